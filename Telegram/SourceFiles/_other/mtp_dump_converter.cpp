@@ -0,0 +1,57 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "mtproto/details/mtproto_binary_dump.h"
+
+#include <QtCore/QFile>
+
+#include <iostream>
+
+// Converts DebugLogs/mtp_*.tlb files, written with the -mtpbinary
+// switch, to the same text the MTP debug log has without it.
+//
+// Usage: MtpDumpConverter <input.tlb> [<output.txt>]
+
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		std::cerr << "Usage: MtpDumpConverter <input.tlb> [<output.txt>]\n";
+		return 1;
+	}
+	auto input = QFile(QString::fromLocal8Bit(argv[1]));
+	if (!input.open(QIODevice::ReadOnly)) {
+		std::cerr << "Could not open '" << argv[1] << "' for reading.\n";
+		return 1;
+	}
+	const auto content = input.readAll();
+	input.close();
+
+	auto output = QFile();
+	const auto opened = (argc > 2)
+		? [&] {
+			output.setFileName(QString::fromLocal8Bit(argv[2]));
+			return output.open(QIODevice::WriteOnly | QIODevice::Text);
+		}()
+		: output.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+	if (!opened) {
+		std::cerr << "Could not open the output for writing.\n";
+		return 1;
+	}
+
+	auto count = 0;
+	const auto valid = MTP::details::ReadBinaryDump(content, [&](
+			MTP::details::BinaryDumpRecord &&record) {
+		output.write(MTP::details::BinaryDumpRecordToText(record).toUtf8());
+		output.write("\n");
+		++count;
+	});
+	if (!valid) {
+		std::cerr << "Bad binary dump header in '" << argv[1] << "'.\n";
+		return 1;
+	}
+	std::cerr << count << " records converted.\n";
+	return 0;
+}
@@ -60,6 +60,9 @@ namespace {
 
 constexpr auto kChannelGetDifferenceLimit = 100;
 
+// Messages and updates from getDifference applied per event loop iteration.
+constexpr auto kDifferenceChunkSize = 200;
+
 // 1s wait after show channel history before sending getChannelDifference.
 constexpr auto kWaitForChannelGetDifference = crl::time(1000);
 
@@ -468,23 +471,25 @@ void Updates::differenceDone(const MTPupdates_Difference &result) {
 	} break;
 	case mtpc_updates_differenceSlice: {
 		auto &d = result.c_updates_differenceSlice();
-		feedDifference(d.vusers(), d.vchats(), d.vnew_messages(), d.vother_updates());
-
-		auto &s = d.vintermediate_state().c_updates_state();
-		setState(s.vpts().v, s.vdate().v, s.vqts().v, s.vseq().v);
+		const auto state = d.vintermediate_state();
+		feedDifference(d.vusers(), d.vchats(), d.vnew_messages(), d.vother_updates(), [=] {
+			auto &s = state.c_updates_state();
+			setState(s.vpts().v, s.vdate().v, s.vqts().v, s.vseq().v);
 
-		_ptsWaiter.setRequesting(false);
+			_ptsWaiter.setRequesting(false);
 
-		MTP_LOG(0, ("getDifference "
-			"{ good - after a slice of difference was received }%1"
-			).arg(_session->mtp().isTestMode() ? " TESTMODE" : ""));
-		getDifference();
+			MTP_LOG(0, ("getDifference "
+				"{ good - after a slice of difference was received }%1"
+				).arg(_session->mtp().isTestMode() ? " TESTMODE" : ""));
+			getDifference();
+		});
 	} break;
 	case mtpc_updates_difference: {
 		auto &d = result.c_updates_difference();
-		feedDifference(d.vusers(), d.vchats(), d.vnew_messages(), d.vother_updates());
-
-		stateDone(d.vstate());
+		const auto state = d.vstate();
+		feedDifference(d.vusers(), d.vchats(), d.vnew_messages(), d.vother_updates(), [=] {
+			stateDone(state);
+		});
 	} break;
 	case mtpc_updates_differenceTooLong: {
 		LOG(("API Error: updates.differenceTooLong is not supported by Telegram Desktop!"));
@@ -581,13 +586,91 @@ void Updates::feedDifference(
 		const MTPVector<MTPUser> &users,
 		const MTPVector<MTPChat> &chats,
 		const MTPVector<MTPMessage> &msgs,
-		const MTPVector<MTPUpdate> &other) {
+		const MTPVector<MTPUpdate> &other,
+		Fn<void()> done) {
+	Expects(!_pendingDifference.has_value());
+
 	Core::App().checkAutoLock();
 	session().data().processUsers(users);
 	session().data().processChats(chats);
 	feedMessageIds(other);
-	session().data().processMessages(msgs, NewMessageType::Unread);
-	feedUpdateVector(other, SkipUpdatePolicy::SkipMessageIds);
+
+	// Messages of the same peer are applied together, the id order
+	// inside each peer is preserved by processMessages() anyway.
+	auto messages = msgs.v;
+	ranges::stable_sort(messages, std::less<>(), [](const MTPMessage &m) {
+		return PeerFromMessage(m).value;
+	});
+
+	// Other updates keep the server order, except group call
+	// participants, the same way feedUpdateVector() applies them.
+	auto updates = QVector<MTPUpdate>();
+	updates.reserve(other.v.size());
+	for (const auto &update : other.v) {
+		if (update.type() != mtpc_updateMessageID) {
+			updates.push_back(update);
+		}
+	}
+	ranges::stable_sort(updates, std::less<>(), [](const MTPUpdate &u) {
+		return (u.type() == mtpc_updateGroupCallParticipants) ? 0 : 1;
+	});
+
+	session().data().startUpdatesBatch();
+	_pendingDifference = PendingDifference{
+		.messages = std::move(messages),
+		.updates = std::move(updates),
+		.done = std::move(done),
+	};
+	applyDifferenceChunk();
+}
+
+void Updates::applyDifferenceChunk() {
+	Expects(_pendingDifference.has_value());
+
+	auto &owner = session().data();
+	auto &pending = *_pendingDifference;
+	const auto messagesCount = int(pending.messages.size());
+	const auto updatesCount = int(pending.updates.size());
+	auto left = kDifferenceChunkSize;
+	if (pending.messagesApplied < messagesCount) {
+		const auto count = std::min(
+			left,
+			messagesCount - pending.messagesApplied);
+		owner.processMessages(
+			pending.messages.mid(pending.messagesApplied, count),
+			NewMessageType::Unread);
+		pending.messagesApplied += count;
+		left -= count;
+	}
+	while (left > 0 && pending.updatesApplied < updatesCount) {
+		feedUpdate(pending.updates[pending.updatesApplied++]);
+		--left;
+	}
+	owner.sendHistoryChangeNotifications();
+
+	if (pending.messagesApplied < messagesCount
+		|| pending.updatesApplied < updatesCount) {
+		// Let the event loop breathe between the chunks.
+		crl::on_main(_session, [=] {
+			applyDifferenceChunk();
+		});
+		return;
+	}
+	const auto done = std::move(pending.done);
+	_pendingDifference = std::nullopt;
+	owner.finishUpdatesBatch();
+	done();
+
+	// The state we've just applied may be older than the updates received
+	// while the chunks were applied, so request the difference once again,
+	// unless done() has already requested the next slice.
+	if (base::take(_differenceRequestedWhilePending)
+		&& !requestingDifference()) {
+		MTP_LOG(0, ("getDifference "
+			"{ good - requested while applying a difference }%1"
+			).arg(_session->mtp().isTestMode() ? " TESTMODE" : ""));
+		getDifference();
+	}
 }
 
 void Updates::differenceFail(const MTP::Error &error) {
@@ -657,7 +740,10 @@ void Updates::getDifferenceAfterFail() {
 void Updates::getDifference() {
 	_getDifferenceTimeByPts = 0;
 
-	if (requestingDifference()) {
+	if (_pendingDifference) {
+		_differenceRequestedWhilePending = true;
+		return;
+	} else if (requestingDifference()) {
 		return;
 	}
 
@@ -1331,6 +1417,9 @@ void Updates::applyUpdates(
 		const MTPUpdates &updates,
 		uint64 sentMessageRandomId) {
 	const auto randomId = sentMessageRandomId;
+	if (_pendingDifference) {
+		_differenceRequestedWhilePending = true;
+	}
 
 	switch (updates.type()) {
 	case mtpc_updates: {
@@ -82,6 +82,14 @@ private:
 		rpl::lifetime lifetime;
 	};
 
+	struct PendingDifference {
+		QVector<MTPMessage> messages;
+		QVector<MTPUpdate> updates;
+		int messagesApplied = 0;
+		int updatesApplied = 0;
+		Fn<void()> done;
+	};
+
 	void channelRangeDifferenceSend(
 		not_null<ChannelData*> channel,
 		MsgRange range,
@@ -108,7 +116,9 @@ private:
 		const MTPVector<MTPUser> &users,
 		const MTPVector<MTPChat> &chats,
 		const MTPVector<MTPMessage> &msgs,
-		const MTPVector<MTPUpdate> &other);
+		const MTPVector<MTPUpdate> &other,
+		Fn<void()> done);
+	void applyDifferenceChunk();
 	void stateDone(const MTPupdates_State &state);
 	void setState(int32 pts, int32 date, int32 qts, int32 seq);
 	void channelDifferenceDone(
@@ -196,6 +206,9 @@ private:
 	crl::time _lastUpdateTime = 0;
 	bool _handlingChannelDifference = false;
 
+	std::optional<PendingDifference> _pendingDifference;
+	bool _differenceRequestedWhilePending = false;
+
 	base::flat_map<int, ActiveChatTracker> _activeChats;
 	base::flat_map<
 		not_null<PeerData*>,
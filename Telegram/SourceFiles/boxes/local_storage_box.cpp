@@ -17,6 +17,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/text/format_values.h"
 #include "ui/emoji_config.h"
 #include "storage/storage_account.h"
+#include "storage/storage_cache_analytics.h"
+#include "storage/storage_cache_dedup.h"
 #include "storage/cache/storage_cache_database.h"
 #include "data/data_session.h"
 #include "lang/lang_keys.h"
@@ -34,6 +36,7 @@ constexpr auto kMinimalSizeLimit = 100 * kMegabyte;
 constexpr auto kTimeLimitsCount = 16;
 constexpr auto kMaxTimeLimitValue = std::numeric_limits<size_type>::max();
 constexpr auto kFakeMediaCacheTag = uint16(0xFFFF);
+constexpr auto kMinHitRateRequests = 20;
 
 int64 TotalSizeLimitInMB(int index) {
 	if (index < 8) {
@@ -110,6 +113,14 @@ QString TimeLimitText(size_type limit) {
 		: tr::lng_local_storage_limit_never(tr::now);
 }
 
+QString HitRateText(const Storage::CacheTagHits &hits) {
+	const auto requests = hits.hits + hits.misses;
+	if (requests < kMinHitRateRequests) {
+		return QString();
+	}
+	return QString::number(hits.hits * 100 / requests);
+}
+
 size_type LimitToValue(size_type timeLimit) {
 	return timeLimit ? timeLimit : kMaxTimeLimitValue;
 }
@@ -129,6 +140,7 @@ public:
 		const Database::TaggedSummary &data);
 
 	void update(const Database::TaggedSummary &data);
+	void setHitRate(const QString &hitRate);
 	void toggleProgress(bool shown);
 
 	rpl::producer<> clearRequests() const;
@@ -143,6 +155,8 @@ private:
 	void radialAnimationCallback();
 
 	Fn<QString(size_type)> _titleFactory;
+	Database::TaggedSummary _data;
+	QString _hitRate;
 	object_ptr<Ui::FlatLabel> _title;
 	object_ptr<Ui::FlatLabel> _description;
 	object_ptr<Ui::FlatLabel> _clearing = { nullptr };
@@ -158,6 +172,7 @@ LocalStorageBox::Row::Row(
 	const Database::TaggedSummary &data)
 : RpWidget(parent)
 , _titleFactory(std::move(title))
+, _data(data)
 , _title(
 	this,
 	titleText(data),
@@ -172,6 +187,7 @@ LocalStorageBox::Row::Row(
 }
 
 void LocalStorageBox::Row::update(const Database::TaggedSummary &data) {
+	_data = data;
 	if (data.count != 0) {
 		_title->setText(titleText(data));
 	}
@@ -179,6 +195,13 @@ void LocalStorageBox::Row::update(const Database::TaggedSummary &data) {
 	_clear->setVisible(data.count != 0);
 }
 
+void LocalStorageBox::Row::setHitRate(const QString &hitRate) {
+	if (_hitRate != hitRate) {
+		_hitRate = hitRate;
+		_description->setText(sizeText(_data));
+	}
+}
+
 void LocalStorageBox::Row::toggleProgress(bool shown) {
 	if (!shown) {
 		_progress = nullptr;
@@ -260,9 +283,17 @@ QString LocalStorageBox::Row::titleText(const Database::TaggedSummary &data) con
 }
 
 QString LocalStorageBox::Row::sizeText(const Database::TaggedSummary &data) const {
-	return data.totalSize
-		? Ui::FormatSizeText(data.totalSize)
-		: tr::lng_local_storage_empty(tr::now);
+	if (!data.totalSize) {
+		return tr::lng_local_storage_empty(tr::now);
+	} else if (_hitRate.isEmpty()) {
+		return Ui::FormatSizeText(data.totalSize);
+	}
+	return tr::lng_local_storage_hit_rate(
+		tr::now,
+		lt_size,
+		Ui::FormatSizeText(data.totalSize),
+		lt_percent,
+		_hitRate);
 }
 
 LocalStorageBox::LocalStorageBox(
@@ -392,11 +423,17 @@ void LocalStorageBox::setupControls() {
 		auto title = [factory = std::move(factory)](size_type count) {
 			return factory(tr::now, lt_count, count);
 		};
-		tracker.track(createRow(
+		const auto row = createRow(
 			tag,
 			std::move(title),
 			tr::lng_local_storage_clear_some(),
-			data));
+			data);
+		tracker.track(row);
+		_session->data().cacheAnalytics().hitsValue(
+			tag
+		) | rpl::start_with_next([=](const Storage::CacheTagHits &hits) {
+			row->entity()->setHitRate(HitRateText(hits));
+		}, row->lifetime());
 	};
 	auto summaryTitle = [](size_type) {
 		return tr::lng_local_storage_summary(tr::now);
@@ -409,6 +446,7 @@ void LocalStorageBox::setupControls() {
 		std::move(summaryTitle),
 		tr::lng_local_storage_clear(),
 		summary());
+	setupDedupStats(container);
 	setupLimits(container);
 	const auto shadow = container->add(object_ptr<Ui::SlideWrap<>>(
 		container,
@@ -516,6 +554,34 @@ void LocalStorageBox::updateMediaLabel() {
 	_mediaLabel->setText(tr::lng_local_storage_media_limit(tr::now, lt_size, text));
 }
 
+void LocalStorageBox::setupDedupStats(
+		not_null<Ui::VerticalLayout*> container) {
+	auto stats = _session->data().cacheDedup().statsValue();
+	const auto wrap = container->add(
+		object_ptr<Ui::SlideWrap<Ui::FlatLabel>>(
+			container,
+			object_ptr<Ui::FlatLabel>(
+				container,
+				rpl::duplicate(
+					stats
+				) | rpl::map([](const Storage::CacheDedupStats &stats) {
+					return tr::lng_local_storage_dedup(
+						tr::now,
+						lt_count,
+						stats.count,
+						lt_size,
+						Ui::FormatSizeText(stats.savedSize));
+				}),
+				st::localStorageRowSize),
+			st::localStorageRowPadding));
+	wrap->toggleOn(std::move(
+		stats
+	) | rpl::map([](const Storage::CacheDedupStats &stats) {
+		return (stats.count > 0);
+	}));
+	wrap->finishAnimating();
+}
+
 void LocalStorageBox::setupLimits(not_null<Ui::VerticalLayout*> container) {
 	container->add(
 		object_ptr<Ui::PlainShadow>(container),
@@ -54,6 +54,7 @@ private:
 		not_null<Ui::SlideWrap<Row>*> row,
 		const Database::TaggedSummary *data);
 	void setupControls();
+	void setupDedupStats(not_null<Ui::VerticalLayout*> container);
 	void setupLimits(not_null<Ui::VerticalLayout*> container);
 	void updateMediaLimit();
 	void updateTotalLimit();
@@ -273,7 +273,7 @@ protected:
 private:
 	struct Element {
 		not_null<DocumentData*> document;
-		std::shared_ptr<Data::DocumentMedia> documentMedia;
+		mutable std::shared_ptr<Data::DocumentMedia> documentMedia;
 		Lottie::Animation *lottie = nullptr;
 		Media::Clip::ReaderPointer webm;
 		Ui::Text::CustomEmoji *emoji = nullptr;
@@ -296,6 +296,7 @@ private:
 		bool paused,
 		crl::time now) const;
 	void setupLottie(int index);
+	void unloadInRows(int fromRow, int tillRow);
 	void setupWebm(int index);
 	void clipCallback(
 		Media::Clip::Notification notification,
@@ -710,10 +711,7 @@ void StickerSetBox::Inner::gotSet(const MTPmessages_StickerSet &set) {
 			}
 			_pack.push_back(document);
 			if (!document->isPremiumSticker() || premiumPossible) {
-				_elements.push_back({
-					document,
-					document->createMediaView(),
-				});
+				_elements.push_back({ document });
 			}
 		}
 		for (const auto &pack : data.vpacks().v) {
@@ -1211,6 +1209,40 @@ void StickerSetBox::Inner::visibleTopBottomUpdated(
 			_rowsCount);
 		pauseInRows(_rowsCount - pauseRows, _rowsCount);
 	}
+
+	// Keep one screen of rows above and below ready for scrolling.
+	if (singleHeight > 0) {
+		const auto visibleHeight = visibleBottom - visibleTop;
+		const auto keepTop = visibleTop - visibleHeight - rowsTop;
+		const auto keepBottom = visibleBottom + visibleHeight - rowsTop;
+		const auto keepFrom = std::clamp(
+			keepTop / singleHeight,
+			0,
+			_rowsCount);
+		const auto keepTill = std::clamp(
+			(keepBottom + singleHeight - 1) / singleHeight,
+			keepFrom,
+			_rowsCount);
+		unloadInRows(0, keepFrom);
+		unloadInRows(keepTill, _rowsCount);
+	}
+}
+
+void StickerSetBox::Inner::unloadInRows(int fromRow, int tillRow) {
+	const auto from = std::min(fromRow * _perRow, int(_elements.size()));
+	const auto till = std::min(tillRow * _perRow, int(_elements.size()));
+	for (auto i = from; i < till; ++i) {
+		auto &element = _elements[i];
+		if (!element.documentMedia) {
+			continue;
+		}
+		if (const auto lottie = base::take(element.lottie)) {
+			_lottiePlayer->remove(lottie);
+		}
+		element.webm = nullptr;
+		element.documentMedia = nullptr;
+		element.document->cancelThumbnailLoad();
+	}
 }
 
 void StickerSetBox::Inner::setupLottie(int index) {
@@ -1312,6 +1344,9 @@ void StickerSetBox::Inner::paintSticker(
 
 	const auto &element = _elements[index];
 	const auto document = element.document;
+	if (!element.documentMedia) {
+		element.documentMedia = document->createMediaView();
+	}
 	const auto &media = element.documentMedia;
 	const auto sticker = document->sticker();
 	media->checkStickerSmall();
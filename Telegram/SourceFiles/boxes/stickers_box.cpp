@@ -232,6 +232,8 @@ private:
 		Media::Clip::Notification notification);
 
 	void readVisibleSets();
+	void unloadInvisibleRows();
+	void unloadRow(not_null<Row*> row);
 
 	void updateControlsGeometry();
 	void rebuildAppendSet(not_null<StickersSet*> set, int maxNameWidth);
@@ -2092,6 +2094,7 @@ void StickersBox::Inner::rebuildMegagroupSet() {
 }
 
 void StickersBox::Inner::rebuild(bool masks) {
+	session().data().stickers().loadPendingSets();
 	_itemsTop = st::membersMarginTop;
 
 	if (_megagroupSet) {
@@ -2489,6 +2492,7 @@ void StickersBox::Inner::visibleTopBottomUpdated(
 	if (_section == Section::Featured) {
 		readVisibleSets();
 	}
+	unloadInvisibleRows();
 	checkLoadMore();
 }
 
@@ -2534,6 +2538,33 @@ void StickersBox::Inner::readVisibleSets() {
 	}
 }
 
+void StickersBox::Inner::unloadInvisibleRows() {
+	// Keep one screen of rows above and below ready for scrolling.
+	const auto visibleHeight = _visibleBottom - _visibleTop;
+	const auto keepTop = _visibleTop - visibleHeight - _itemsTop;
+	const auto keepBottom = _visibleBottom + visibleHeight - _itemsTop;
+	for (auto i = 0, count = int(_rows.size()); i != count; ++i) {
+		const auto top = i * _rowHeight;
+		if (top + _rowHeight <= keepTop || top >= keepBottom) {
+			unloadRow(_rows[i].get());
+		}
+	}
+}
+
+void StickersBox::Inner::unloadRow(not_null<Row*> row) {
+	if (!row->stickerMedia && !row->thumbnailMedia) {
+		return;
+	}
+	row->lottie = nullptr;
+	row->webm = nullptr;
+	row->stickerMedia = nullptr;
+	row->thumbnailMedia = nullptr;
+	row->set->cancelThumbnailLoad();
+	if (row->sticker) {
+		row->sticker->cancelThumbnailLoad();
+	}
+}
+
 void StickersBox::Inner::updateScrollbarWidth() {
 	auto width = (_visibleBottom - _visibleTop < height()) ? (st::boxScroll.width - st::boxScroll.deltax) : 0;
 	if (_scrollbar != width) {
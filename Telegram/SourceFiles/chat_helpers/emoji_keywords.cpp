@@ -26,6 +26,8 @@ namespace {
 constexpr auto kRefreshEach = 60 * 60 * crl::time(1000); // 1 hour.
 constexpr auto kKeepNotUsedLangPacksCount = 4;
 constexpr auto kKeepNotUsedInputLanguagesCount = 4;
+constexpr auto kPrecomputedPrefixLength = 2;
+constexpr auto kPrecomputedKeysMin = 64;
 
 using namespace Ui::Emoji;
 
@@ -36,12 +38,51 @@ struct LangPackEmoji {
 	QString text;
 };
 
+using LangPackEntry = std::pair<
+	const QString,
+	std::vector<LangPackEmoji>>;
+
+// Prefix tree over the sorted keywords, each node covers a range of keys.
+struct LangPackIndex {
+	struct Node {
+		int keysFrom = 0;
+		int keysTill = 0;
+		int edgesFrom = 0;
+		int edgesTill = 0;
+		int exact = -1;
+	};
+	struct Edge {
+		QChar ch;
+		int node = 0;
+	};
+	std::vector<Node> nodes;
+	std::vector<Edge> edges;
+	std::vector<not_null<const LangPackEntry*>> keys;
+
+	// Short prefixes match most of the keys, so their results are ready.
+	base::flat_map<int, std::vector<Result>> precomputed;
+};
+
 struct LangPackData {
+	LangPackData() = default;
+	LangPackData(LangPackData &&other) = default;
+	LangPackData &operator=(LangPackData &&other) = default;
+
+	// A copy gets its own index, pointing into its own emoji map.
+	LangPackData(const LangPackData &other);
+	LangPackData &operator=(const LangPackData &other);
+
 	int version = 0;
 	int maxKeyLength = 0;
 	std::map<QString, std::vector<LangPackEmoji>> emoji;
+
+	// Points into the emoji map, compiled again after each change.
+	// Moving the map keeps its nodes, so moves keep the index valid.
+	LangPackIndex index;
 };
 
+void CompileIndex(LangPackData &data);
+
 [[nodiscard]] bool MustAddPostfix(const QString &text) {
 	if (text.size() != 1) {
 		return false;
@@ -136,6 +177,7 @@ void CreateCacheFilePath() {
 		result.maxKeyLength = std::max(result.maxKeyLength, int(key.size()));
 	}
 	result.version = version;
+	CompileIndex(result);
 	return result;
 }
 
@@ -195,6 +237,77 @@ void AppendFoundEmoji(
 	result.insert(end(result), add.begin(), add.end());
 }
 
+void AppendFoundEmoji(
+		std::vector<Result> &result,
+		const LangPackIndex &index,
+		const LangPackIndex::Node &node) {
+	for (auto i = node.keysFrom; i != node.keysTill; ++i) {
+		const auto &[key, list] = *index.keys[i];
+		AppendFoundEmoji(result, key, list);
+	}
+}
+
+void CompileIndex(LangPackData &data) {
+	auto &index = data.index;
+	index = LangPackIndex();
+	index.keys.reserve(data.emoji.size());
+	index.nodes.push_back({});
+
+	// Keys come sorted, so a new child always goes after the existing ones.
+	auto children = std::vector<std::vector<LangPackIndex::Edge>>(1);
+	auto depths = std::vector<int>(1);
+	for (const auto &entry : data.emoji) {
+		const auto k = int(index.keys.size());
+		index.keys.push_back(&entry);
+		auto node = 0;
+		index.nodes[node].keysTill = k + 1;
+		for (const auto ch : entry.first) {
+			if (children[node].empty() || children[node].back().ch != ch) {
+				const auto child = int(index.nodes.size());
+				children[node].push_back({ ch, child });
+				index.nodes.push_back({ .keysFrom = k });
+				children.emplace_back();
+				depths.push_back(depths[node] + 1);
+			}
+			node = children[node].back().node;
+			index.nodes[node].keysTill = k + 1;
+		}
+		index.nodes[node].exact = k;
+	}
+	for (auto i = 0, count = int(index.nodes.size()); i != count; ++i) {
+		auto &node = index.nodes[i];
+		node.edgesFrom = int(index.edges.size());
+		index.edges.insert(
+			end(index.edges),
+			begin(children[i]),
+			end(children[i]));
+		node.edgesTill = int(index.edges.size());
+
+		if (depths[i] > 0
+			&& depths[i] <= kPrecomputedPrefixLength
+			&& node.keysTill - node.keysFrom >= kPrecomputedKeysMin) {
+			AppendFoundEmoji(index.precomputed[i], index, node);
+		}
+	}
+}
+
+LangPackData::LangPackData(const LangPackData &other)
+: version(other.version)
+, maxKeyLength(other.maxKeyLength)
+, emoji(other.emoji) {
+	CompileIndex(*this);
+}
+
+LangPackData &LangPackData::operator=(const LangPackData &other) {
+	if (this != &other) {
+		version = other.version;
+		maxKeyLength = other.maxKeyLength;
+		emoji = other.emoji;
+		CompileIndex(*this);
+	}
+	return *this;
+}
+
 void AppendLegacySuggestions(
 		std::vector<Result> &result,
 		const QString &query) {
@@ -299,6 +412,7 @@ void ApplyDifference(
 		});
 		data.maxKeyLength = *ranges::max_element(lengths);
 	}
+	CompileIndex(data);
 }
 
 } // namespace
@@ -432,7 +546,11 @@ void EmojiKeywords::LangPack::applyDifference(
 			return;
 		}
 		const auto id = _id;
-		auto copy = _data;
+		// The index is compiled by ApplyDifference, don't copy it here.
+		auto copy = LangPackData();
+		copy.version = _data.version;
+		copy.maxKeyLength = _data.maxKeyLength;
+		copy.emoji = _data.emoji;
 		auto callback = crl::guard(_guard.make_guard(), [=](
 				LangPackData &&result) {
 			applyData(std::move(result));
@@ -477,18 +595,36 @@ std::vector<Result> EmojiKeywords::LangPack::query(
 		return {};
 	}
 
-	const auto from = _data.emoji.lower_bound(normalized);
-	auto &&chosen = ranges::make_subrange(
-		from,
-		end(_data.emoji)
-	) | ranges::views::take_while([&](const auto &pair) {
-		const auto &key = pair.first;
-		return exact ? (key == normalized) : key.startsWith(normalized);
-	});
+	const auto &index = _data.index;
+	auto node = 0;
+	for (const auto ch : normalized) {
+		const auto &from = index.nodes[node];
+		const auto edges = ranges::make_subrange(
+			begin(index.edges) + from.edgesFrom,
+			begin(index.edges) + from.edgesTill);
+		const auto i = ranges::lower_bound(
+			edges,
+			ch,
+			ranges::less(),
+			&LangPackIndex::Edge::ch);
+		if (i == edges.end() || i->ch != ch) {
+			return {};
+		}
+		node = i->node;
+	}
 
+	const auto &found = index.nodes[node];
 	auto result = std::vector<Result>();
-	for (const auto &[key, list] : chosen) {
-		AppendFoundEmoji(result, key, list);
+	if (exact) {
+		if (found.exact >= 0) {
+			const auto &[key, list] = *index.keys[found.exact];
+			AppendFoundEmoji(result, key, list);
+		}
+	} else if (const auto i = index.precomputed.find(node)
+		; i != end(index.precomputed)) {
+		result = i->second;
+	} else {
+		AppendFoundEmoji(result, index, found);
 	}
 	return result;
 }
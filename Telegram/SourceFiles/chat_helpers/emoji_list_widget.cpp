@@ -574,7 +574,9 @@ void EmojiListWidget::unloadCustomIn(const SectionInfo &info) {
 	}
 	custom.painted = false;
 	for (const auto &single : custom.list) {
-		single.custom->unload();
+		if (const auto emoji = single.custom) {
+			emoji->unload();
+		}
 	}
 }
 
@@ -1065,6 +1067,9 @@ void EmojiListWidget::drawCustom(
 	auto &custom = _custom[set];
 	custom.painted = true;
 	auto &entry = custom.list[index];
+	if (!entry.custom) {
+		entry.custom = resolveCustomEmoji(entry.document, custom.id);
+	}
 	entry.custom->paint(p, {
 		.preview = st::windowBgRipple->c,
 		.colored = _emojiStatusColor.get(),
@@ -1571,6 +1576,7 @@ void EmojiListWidget::refreshCustom() {
 		&& !session->premium()
 		&& !_allowWithoutPremium;
 	const auto owner = &session->data();
+	owner->stickers().loadPendingSets();
 	const auto &sets = owner->stickers().sets();
 	const auto push = [&](uint64 setId, bool installed) {
 		auto it = sets.find(setId);
@@ -1626,10 +1632,8 @@ void EmojiListWidget::refreshCustom() {
 		set.reserve(list.size());
 		for (const auto document : list) {
 			if (document->sticker()) {
-				set.push_back({
-					.custom = resolveCustomEmoji(document, setId),
-					.document = document,
-				});
+				// Emoji instances are created only for painted sections.
+				set.push_back({ .document = document });
 				if (!premium && document->isPremiumEmoji()) {
 					premium = true;
 				}
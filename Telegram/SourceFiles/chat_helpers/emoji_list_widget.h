@@ -159,7 +159,7 @@ private:
 		bool collapsed = false;
 	};
 	struct CustomOne {
-		not_null<Ui::Text::CustomEmoji*> custom;
+		Ui::Text::CustomEmoji *custom = nullptr; // Resolved when painted.
 		not_null<DocumentData*> document;
 	};
 	struct CustomSet {
@@ -81,6 +81,8 @@ struct StickersListWidget::Sticker {
 	QImage savedFrame;
 	QSize savedFrameFor;
 	QImage premiumLock;
+	bool firstFrameRequested = false;
+	bool firstFrameStored = false;
 
 	void ensureMediaCreated();
 };
@@ -725,6 +727,8 @@ void StickersListWidget::takeHeavyData(Sticker &to, Sticker &from) {
 	to.documentMedia = std::move(from.documentMedia);
 	to.savedFrame = std::move(from.savedFrame);
 	to.savedFrameFor = from.savedFrameFor;
+	to.firstFrameRequested = from.firstFrameRequested;
+	to.firstFrameStored = from.firstFrameStored;
 	to.lottie = base::take(from.lottie);
 	to.webm = base::take(from.webm);
 }
@@ -992,6 +996,8 @@ void StickersListWidget::clearHeavyIn(Set &set, bool clearSavedFrames) {
 		if (clearSavedFrames) {
 			sticker.savedFrame = QImage();
 			sticker.savedFrameFor = QSize();
+			sticker.firstFrameRequested = false;
+			sticker.firstFrameStored = false;
 		}
 		sticker.webm = nullptr;
 		sticker.lottie = nullptr;
@@ -1136,6 +1142,66 @@ void StickersListWidget::setupWebm(Set &set, int section, int index) {
 		std::move(callback));
 }
 
+void StickersListWidget::loadFirstFrame(Set &set, int index) {
+	auto &sticker = set.stickers[index];
+	sticker.firstFrameRequested = true;
+
+	const auto setId = set.id;
+	const auto document = sticker.document;
+	LoadStickerFirstFrame(
+		document,
+		StickerLottieSize::StickersPanel,
+		boundingBoxSize() * cIntRetinaFactor(),
+		crl::guard(this, [=](QImage frame) {
+			firstFrameLoaded(setId, document, index, std::move(frame));
+		}));
+}
+
+void StickersListWidget::firstFrameLoaded(
+		uint64 setId,
+		not_null<DocumentData*> document,
+		int indexHint,
+		QImage frame) {
+	if (frame.isNull()) {
+		return;
+	}
+	auto &sets = shownSets();
+	enumerateSections([&](const SectionInfo &info) {
+		auto &set = sets[info.section];
+		if (set.id != setId) {
+			return true;
+		}
+		const auto j = (indexHint < set.stickers.size()
+			&& set.stickers[indexHint].document == document)
+			? (begin(set.stickers) + indexHint)
+			: ranges::find(set.stickers, document, &Sticker::document);
+		if (j == end(set.stickers) || !j->firstFrameRequested) {
+			return false;
+		}
+
+		// Shown instead of the small thumbnail until the animation is ready.
+		j->firstFrameStored = true;
+		j->savedFrame = std::move(frame);
+		j->savedFrame.setDevicePixelRatio(cRetinaFactor());
+		j->savedFrameFor = _singleSize;
+		updateSet(info);
+		return false;
+	});
+}
+
+void StickersListWidget::saveFirstFrame(
+		Sticker &sticker,
+		const QImage &frame) {
+	if (sticker.firstFrameStored || frame.isNull()) {
+		return;
+	}
+	sticker.firstFrameStored = true;
+	SaveStickerFirstFrame(
+		sticker.document,
+		StickerLottieSize::StickersPanel,
+		frame);
+}
+
 void StickersListWidget::clipCallback(
 		Media::Clip::Notification notification,
 		uint64 setId,
@@ -1288,6 +1354,9 @@ void StickersListWidget::paintSticker(
 	const auto premium = document->isPremiumSticker();
 	const auto isLottie = document->sticker()->isLottie();
 	const auto isWebm = document->sticker()->isWebm();
+	if ((isLottie || isWebm) && !sticker.firstFrameRequested) {
+		loadFirstFrame(set, index);
+	}
 	if (isLottie
 		&& !sticker.lottie
 		&& media->loaded()) {
@@ -1320,6 +1389,7 @@ void StickersListWidget::paintSticker(
 		p.drawImage(
 			QRect(ppos, lottieFrame.size() / cIntRetinaFactor()),
 			lottieFrame);
+		saveFirstFrame(sticker, lottieFrame);
 		if (sticker.savedFrame.isNull()) {
 			sticker.savedFrame = lottieFrame;
 			sticker.savedFrame.setDevicePixelRatio(cRetinaFactor());
@@ -1330,6 +1400,7 @@ void StickersListWidget::paintSticker(
 		const auto frame = sticker.webm->current(
 			{ .frame = size, .keepAlpha = true },
 			paused ? 0 : now);
+		saveFirstFrame(sticker, frame);
 		if (sticker.savedFrame.isNull()) {
 			sticker.savedFrame = frame;
 			sticker.savedFrame.setDevicePixelRatio(cRetinaFactor());
@@ -1837,6 +1908,7 @@ void StickersListWidget::clearHeavyData() {
 }
 
 void StickersListWidget::refreshStickers() {
+	session().data().stickers().loadPendingSets();
 	clearSelection();
 
 	refreshMySets();
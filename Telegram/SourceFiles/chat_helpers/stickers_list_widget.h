@@ -255,6 +255,13 @@ private:
 	void ensureLottiePlayer(Set &set);
 	void setupLottie(Set &set, int section, int index);
 	void setupWebm(Set &set, int section, int index);
+	void loadFirstFrame(Set &set, int index);
+	void firstFrameLoaded(
+		uint64 setId,
+		not_null<DocumentData*> document,
+		int indexHint,
+		QImage frame);
+	void saveFirstFrame(Sticker &sticker, const QImage &frame);
 	void clipCallback(
 		Media::Clip::Notification notification,
 		uint64 setId,
@@ -18,13 +18,18 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/view/media/history_view_media_common.h"
 #include "media/clip/media_clip_reader.h"
 #include "ui/effects/path_shift_gradient.h"
+#include "ui/image/image_prepare.h"
 #include "ui/painter.h"
 #include "main/main_session.h"
 
+#include <QtCore/QBuffer>
+
 namespace ChatHelpers {
 namespace {
 
 constexpr auto kDontCacheLottieAfterArea = 512 * 512;
+constexpr auto kFirstFrameKeyShift = 0x100;
+constexpr auto kFirstFrameQuality = 87;
 
 } // namespace
 
@@ -237,6 +242,70 @@ Media::Clip::ReaderPointer WebmThumbnail(
 			std::move(callback));
 }
 
+[[nodiscard]] Storage::Cache::Key StickerFirstFrameKey(
+		not_null<DocumentData*> document,
+		StickerLottieSize sizeTag) {
+	const auto baseKey = document->bigFileBaseCacheKey();
+	if (!baseKey) {
+		return {};
+	}
+
+	// Lottie frame caches take the low eight bits of the key shift.
+	return Storage::Cache::Key{
+		baseKey.high,
+		baseKey.low + kFirstFrameKeyShift + uint8(sizeTag),
+	};
+}
+
+void LoadStickerFirstFrame(
+		not_null<DocumentData*> document,
+		StickerLottieSize sizeTag,
+		QSize box,
+		Fn<void(QImage)> done) {
+	const auto key = StickerFirstFrameKey(document, sizeTag);
+	if (!key) {
+		done(QImage());
+		return;
+	}
+	const auto weak = base::make_weak(&document->session());
+	document->owner().cacheBigFile().get(key, [=](QByteArray &&value) {
+		auto image = value.isEmpty()
+			? QImage()
+			: Images::Read({ .content = value }).image;
+		if (image.width() > box.width() || image.height() > box.height()) {
+			// Saved for a different panel size or screen scale.
+			image = QImage();
+		} else if (!image.isNull()) {
+			image = std::move(image).convertToFormat(
+				QImage::Format_ARGB32_Premultiplied);
+		}
+		crl::on_main(weak, [=, image = std::move(image)]() mutable {
+			done(std::move(image));
+		});
+	});
+}
+
+void SaveStickerFirstFrame(
+		not_null<DocumentData*> document,
+		StickerLottieSize sizeTag,
+		QImage frame) {
+	const auto key = StickerFirstFrameKey(document, sizeTag);
+	if (!key || frame.isNull()) {
+		return;
+	}
+	const auto weak = base::make_weak(&document->session());
+	crl::async([=, frame = std::move(frame)] {
+		auto bytes = QByteArray();
+		auto buffer = QBuffer(&bytes);
+		if (!frame.save(&buffer, "WEBP", kFirstFrameQuality)) {
+			return;
+		}
+		crl::on_main(weak, [=, bytes = std::move(bytes)]() mutable {
+			weak->data().cacheBigFile().put(key, std::move(bytes));
+		});
+	});
+}
+
 bool PaintStickerThumbnailPath(
 		QPainter &p,
 		not_null<Data::DocumentMedia*> media,
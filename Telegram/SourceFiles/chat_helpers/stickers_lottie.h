@@ -109,6 +109,19 @@ enum class StickerLottieSize : uint8 {
 	Data::DocumentMedia *media,
 	Fn<void(Media::Clip::Notification)> callback);
 
+// Compressed static first frames of animated stickers are kept in the
+// cache database, so a sticker can be shown right away next time while
+// its animation is still being prepared.
+void LoadStickerFirstFrame(
+	not_null<DocumentData*> document,
+	StickerLottieSize sizeTag,
+	QSize box,
+	Fn<void(QImage)> done);
+void SaveStickerFirstFrame(
+	not_null<DocumentData*> document,
+	StickerLottieSize sizeTag,
+	QImage frame);
+
 bool PaintStickerThumbnailPath(
 	QPainter &p,
 	not_null<Data::DocumentMedia*> media,
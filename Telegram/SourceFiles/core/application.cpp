@@ -19,6 +19,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "base/qt_signal_producer.h"
 #include "base/unixtime.h"
 #include "core/core_settings.h"
+#include "core/core_trace.h"
 #include "core/update_checker.h"
 #include "core/shortcuts.h"
 #include "core/sandbox.h"
@@ -221,6 +222,8 @@ Application::~Application() {
 }
 
 void Application::run() {
+	TRACE_ZONE("Application::run");
+
 	style::internal::StartFonts();
 
 	ThirdParty::start();
@@ -252,14 +255,17 @@ void Application::run() {
 	_translator = std::make_unique<Lang::Translator>();
 	QCoreApplication::instance()->installTranslator(_translator.get());
 
-	style::startManager(cScale());
-	Ui::InitTextOptions();
-	Ui::StartCachedCorners();
-	Ui::Emoji::Init();
-	Ui::PrepareTextSpoilerMask();
-	startEmojiImageLoader();
-	startSystemDarkModeViewer();
-	Media::Player::start(_audio.get());
+	{
+		TRACE_ZONE("Application::run styles and emoji");
+		style::startManager(cScale());
+		Ui::InitTextOptions();
+		Ui::StartCachedCorners();
+		Ui::Emoji::Init();
+		Ui::PrepareTextSpoilerMask();
+		startEmojiImageLoader();
+		startSystemDarkModeViewer();
+		Media::Player::start(_audio.get());
+	}
 
 	style::ShortAnimationPlaying(
 	) | rpl::start_with_next([=](bool playing) {
@@ -404,6 +410,7 @@ void Application::showOpenGLCrashNotification() {
 }
 
 void Application::startDomain() {
+	TRACE_ZONE("Application::startDomain");
 	const auto state = _domain->start(QByteArray());
 	if (state != Storage::StartResult::IncorrectPasscodeLegacy) {
 		// In case of non-legacy passcoded app all global settings are ready.
@@ -647,6 +654,7 @@ void Application::badMtprotoConfigurationError() {
 }
 
 void Application::startLocalStorage() {
+	TRACE_ZONE("Application::startLocalStorage");
 	Local::start();
 	_saveSettingsTimer.emplace([=] { saveSettings(); });
 	settings().saveDelayedRequests() | rpl::start_with_next([=] {
@@ -690,6 +698,15 @@ bool Application::screenIsLocked() const {
 	return _screenIsLocked;
 }
 
+bool Application::animationsHidden() const {
+	if (_screenIsLocked) {
+		return true;
+	}
+	const auto window = activeWindow() ? activeWindow() : primaryWindow();
+	const auto widget = window ? window->widget().get() : nullptr;
+	return !widget || widget->isHidden() || widget->isMinimized();
+}
+
 void Application::setDefaultFloatPlayerDelegate(
 		not_null<Media::Player::FloatDelegate*> delegate) {
 	Expects(!_defaultFloatPlayerDelegate == !_floatPlayers);
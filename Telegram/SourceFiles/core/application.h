@@ -302,6 +302,10 @@ public:
 	void setScreenIsLocked(bool locked);
 	bool screenIsLocked() const;
 
+	// Nobody sees the animations while the window is hidden or the
+	// screen is locked, they may be played at a much lower rate.
+	[[nodiscard]] bool animationsHidden() const;
+
 	static void RegisterUrlScheme();
 
 protected:
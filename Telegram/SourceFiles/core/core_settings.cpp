@@ -153,7 +153,7 @@ QByteArray Settings::serialize() const {
 		+ Serialize::stringSize(_customDeviceModel.current())
 		+ sizeof(qint32) * 4
 		+ (_accountsOrder.size() * sizeof(quint64))
-		+ sizeof(qint32) * 5;
+		+ sizeof(qint32) * 6;
 
 	auto result = QByteArray();
 	result.reserve(size);
@@ -267,7 +267,8 @@ QByteArray Settings::serialize() const {
 			<< qint32(_chatQuickAction)
 			<< qint32(_hardwareAcceleratedVideo ? 1 : 0)
 			<< qint32(_suggestAnimatedEmoji ? 1 : 0)
-			<< qint32(_cornerReaction.current() ? 1 : 0);
+			<< qint32(_cornerReaction.current() ? 1 : 0)
+			<< qint32(_historiesMemoryBudget.current());
 	}
 	return result;
 }
@@ -361,6 +362,7 @@ void Settings::addFromSerialized(const QByteArray &serialized) {
 	qint32 chatQuickAction = static_cast<qint32>(_chatQuickAction);
 	qint32 suggestAnimatedEmoji = _suggestAnimatedEmoji ? 1 : 0;
 	qint32 cornerReaction = _cornerReaction.current() ? 1 : 0;
+	qint32 historiesMemoryBudget = _historiesMemoryBudget.current();
 
 	stream >> themesAccentColors;
 	if (!stream.atEnd()) {
@@ -558,6 +560,9 @@ void Settings::addFromSerialized(const QByteArray &serialized) {
 	if (!stream.atEnd()) {
 		stream >> cornerReaction;
 	}
+	if (!stream.atEnd()) {
+		stream >> historiesMemoryBudget;
+	}
 	if (stream.status() != QDataStream::Ok) {
 		LOG(("App Error: "
 			"Bad data for Core::Settings::constructFromSerialized()"));
@@ -727,6 +732,7 @@ void Settings::addFromSerialized(const QByteArray &serialized) {
 	}
 	_suggestAnimatedEmoji = (suggestAnimatedEmoji == 1);
 	_cornerReaction = (cornerReaction == 1);
+	_historiesMemoryBudget = std::max(historiesMemoryBudget, 0);
 }
 
 QString Settings::getSoundPath(const QString &key) const {
@@ -423,6 +423,16 @@ public:
 		return _cornerReaction.changes();
 	}
 
+	void setHistoriesMemoryBudget(int megabytes) {
+		_historiesMemoryBudget = megabytes;
+	}
+	[[nodiscard]] int historiesMemoryBudget() const {
+		return _historiesMemoryBudget.current();
+	}
+	[[nodiscard]] rpl::producer<int> historiesMemoryBudgetChanges() const {
+		return _historiesMemoryBudget.changes();
+	}
+
 	void setSpellcheckerEnabled(bool value) {
 		_spellcheckerEnabled = value;
 	}
@@ -744,6 +754,7 @@ private:
 	static constexpr auto kDefaultThirdColumnWidth = 0;
 	static constexpr auto kDefaultDialogsWidthRatio = 5. / 14;
 	static constexpr auto kDefaultBigDialogsWidthRatio = 0.275;
+	static constexpr auto kDefaultHistoriesMemoryBudget = 256; // MB
 
 	struct RecentEmojiPreload {
 		QString emoji;
@@ -795,6 +806,7 @@ private:
 	bool _suggestStickersByEmoji = true;
 	bool _suggestAnimatedEmoji = true;
 	rpl::variable<bool> _cornerReaction = true;
+	rpl::variable<int> _historiesMemoryBudget = kDefaultHistoriesMemoryBudget;
 	rpl::variable<bool> _spellcheckerEnabled = true;
 	rpl::variable<float64> _videoPlaybackSpeed = 1.;
 	float64 _voicePlaybackSpeed = 2.;
@@ -0,0 +1,144 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "core/core_trace.h"
+
+#include <QtCore/QCoreApplication>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+namespace Core {
+namespace details {
+
+std::atomic<bool> TraceEnabledValue = false;
+
+} // namespace details
+
+namespace {
+
+constexpr auto kInstantDuration = int64(-1);
+constexpr auto kReserveEvents = 64 * 1024;
+
+struct TraceEvent {
+	const char *name = nullptr;
+	int64 start = 0;
+	int64 duration = 0;
+	int thread = 0;
+};
+
+std::mutex TraceMutex;
+std::vector<TraceEvent> TraceEvents;
+std::chrono::steady_clock::time_point TraceStarted;
+QString TracePath;
+std::atomic<int> TraceThreadsCount = 0;
+
+[[nodiscard]] int CurrentTraceThread() {
+	// Small per-thread ids, the main thread gets 1 in StartTrace.
+	thread_local const auto result = ++TraceThreadsCount;
+	return result;
+}
+
+void AddTraceEvent(const char *name, int64 start, int64 duration) {
+	const auto thread = CurrentTraceThread();
+	auto lock = std::unique_lock(TraceMutex);
+	TraceEvents.push_back({
+		.name = name,
+		.start = start,
+		.duration = duration,
+		.thread = thread,
+	});
+}
+
+void AppendEscaped(QByteArray &result, const char *value) {
+	for (auto ch = value; *ch; ++ch) {
+		if (*ch == '"' || *ch == '\\') {
+			result.append('\\');
+		} else if (uchar(*ch) < 0x20) {
+			continue;
+		}
+		result.append(*ch);
+	}
+}
+
+} // namespace
+
+int64 details::TraceNow() {
+	using namespace std::chrono;
+	const auto elapsed = steady_clock::now() - TraceStarted;
+	return duration_cast<microseconds>(elapsed).count();
+}
+
+void details::TraceAdd(const char *name, int64 start, int64 finish) {
+	AddTraceEvent(name, start, finish - start);
+}
+
+void StartTrace(const QString &path) {
+	if (path.isEmpty() || TraceEnabled()) {
+		return;
+	}
+	TracePath = path;
+	TraceStarted = std::chrono::steady_clock::now();
+	TraceEvents.reserve(kReserveEvents);
+	CurrentTraceThread();
+	details::TraceEnabledValue.store(true, std::memory_order_release);
+}
+
+void TraceInstant(const char *name) {
+	if (TraceEnabled()) {
+		AddTraceEvent(name, details::TraceNow(), kInstantDuration);
+	}
+}
+
+void FinishTrace() {
+	if (!details::TraceEnabledValue.exchange(false)) {
+		return;
+	}
+
+	auto events = [&] {
+		auto lock = std::unique_lock(TraceMutex);
+		return base::take(TraceEvents);
+	}();
+	const auto pid = QByteArray::number(QCoreApplication::applicationPid());
+	auto result = QByteArray();
+	result.reserve(events.size() * 96 + 256);
+	result.append("{\"traceEvents\":[\n");
+	result.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":");
+	result.append(pid);
+	result.append(",\"tid\":1,\"args\":{\"name\":\"main\"}}");
+	for (const auto &event : events) {
+		result.append(",\n{\"name\":\"");
+		AppendEscaped(result, event.name);
+		if (event.duration == kInstantDuration) {
+			result.append("\",\"ph\":\"i\",\"s\":\"t\",\"ts\":");
+			result.append(QByteArray::number(event.start));
+		} else {
+			result.append("\",\"ph\":\"X\",\"ts\":");
+			result.append(QByteArray::number(event.start));
+			result.append(",\"dur\":");
+			result.append(QByteArray::number(event.duration));
+		}
+		result.append(",\"pid\":");
+		result.append(pid);
+		result.append(",\"tid\":");
+		result.append(QByteArray::number(event.thread));
+		result.append('}');
+	}
+	result.append("\n]}\n");
+
+	auto file = QFile(TracePath);
+	if (!file.open(QIODevice::WriteOnly) || file.write(result) < 0) {
+		LOG(("Trace Error: Could not write '%1'.").arg(TracePath));
+		return;
+	}
+	LOG(("Trace Info: %1 events written to '%2'."
+		).arg(events.size()
+		).arg(TracePath));
+}
+
+} // namespace Core
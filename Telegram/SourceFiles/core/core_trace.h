@@ -0,0 +1,61 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <atomic>
+
+namespace Core {
+namespace details {
+
+extern std::atomic<bool> TraceEnabledValue;
+
+[[nodiscard]] int64 TraceNow();
+void TraceAdd(const char *name, int64 start, int64 finish);
+
+} // namespace details
+
+// Enabled by the -trace <path> command line switch, writes the zones
+// in Chrome trace event format (chrome://tracing, Perfetto) on exit.
+void StartTrace(const QString &path);
+void FinishTrace();
+
+[[nodiscard]] inline bool TraceEnabled() {
+	return details::TraceEnabledValue.load(std::memory_order_relaxed);
+}
+
+void TraceInstant(const char *name);
+
+// The name must be a string literal, it is stored as a pointer.
+class TraceZone final {
+public:
+	explicit TraceZone(const char *name)
+	: _name(TraceEnabled() ? name : nullptr)
+	, _start(_name ? details::TraceNow() : 0) {
+	}
+	TraceZone(const TraceZone &other) = delete;
+	TraceZone &operator=(const TraceZone &other) = delete;
+	~TraceZone() {
+		if (_name) {
+			details::TraceAdd(_name, _start, details::TraceNow());
+		}
+	}
+
+private:
+	const char *_name = nullptr;
+	int64 _start = 0;
+
+};
+
+} // namespace Core
+
+#define TRACE_ZONE_CONCAT_INNER(a, b) a##b
+#define TRACE_ZONE_CONCAT(a, b) TRACE_ZONE_CONCAT_INNER(a, b)
+#define TRACE_ZONE(name) const auto TRACE_ZONE_CONCAT(\
+	traceZone, \
+	__LINE__) = Core::TraceZone(name)
+//usage TRACE_ZONE("Application::run");
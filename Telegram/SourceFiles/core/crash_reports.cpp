@@ -253,6 +253,7 @@ void SignalHandler(int signum) {
 
 	if (ReportingThreadId.compare_exchange_strong(expected, thread)) {
 		WriteReportInfo(signum, name);
+		Logs::flushOnCrash();
 		ReportingThreadId = nullptr;
 	}
 
@@ -13,6 +13,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "base/platform/base_platform_file_utilities.h"
 #include "ui/main_queue_processor.h"
 #include "core/crash_reports.h"
+#include "core/core_trace.h"
 #include "core/update_checker.h"
 #include "core/sandbox.h"
 #include "base/concurrent_timer.h"
@@ -357,6 +358,7 @@ int Launcher::exec() {
 		launchUpdater(UpdaterLaunch::JustRelaunch);
 	}
 
+	FinishTrace();
 	CrashReports::Finish();
 	Platform::finish();
 	Logs::finish();
@@ -481,6 +483,8 @@ void Launcher::processArguments() {
 		{ "-workdir"        , KeyFormat::OneValue },
 		{ "--"              , KeyFormat::OneValue },
 		{ "-scale"          , KeyFormat::OneValue },
+		{ "-trace"          , KeyFormat::OneValue },
+		{ "-mtpbinary"      , KeyFormat::NoValues },
 	};
 	auto parseResult = QMap<QByteArray, QStringList>();
 	auto parsingKey = QByteArray();
@@ -528,6 +532,11 @@ void Launcher::processArguments() {
 	}
 	gStartUrl = parseResult.value("--", {}).join(QString());
 
+	Logs::SetMtpBinaryEnabled(parseResult.contains("-mtpbinary"));
+	if (parseResult.contains("-trace")) {
+		StartTrace(parseResult.value("-trace", {}).join(QString()));
+	}
+
 	const auto scaleKey = parseResult.value("-scale", {});
 	if (scaleKey.size() > 0) {
 		using namespace style;
@@ -539,6 +548,7 @@ void Launcher::processArguments() {
 }
 
 int Launcher::executeApplication() {
+	TRACE_ZONE("Launcher::executeApplication");
 	FilteredCommandLineArguments arguments(_argc, _argv);
 	Sandbox sandbox(this, arguments.count(), arguments.values());
 	Ui::MainQueueProcessor processor;
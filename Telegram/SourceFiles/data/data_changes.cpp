@@ -10,12 +10,18 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "main/main_session.h"
 
 namespace Data {
+namespace {
+
+constexpr auto kLogStatsTimeout = 15 * 60 * crl::time(1000);
+
+} // namespace
 
 template <typename DataType, typename UpdateType>
 void Changes::Manager<DataType, UpdateType>::updated(
 		not_null<DataType*> data,
 		Flags flags,
 		bool dropScheduled) {
+	++_stats.fired;
 	sendRealtimeNotifications(data, flags);
 	if (dropScheduled) {
 		const auto i = _updates.find(data);
@@ -23,12 +29,66 @@ void Changes::Manager<DataType, UpdateType>::updated(
 			flags |= i->second;
 			_updates.erase(i);
 		}
-		_stream.fire({ data, flags });
+		send({ data, flags });
 	} else {
 		_updates[data] |= flags;
 	}
 }
 
+template <typename DataType, typename UpdateType>
+void Changes::Manager<DataType, UpdateType>::send(UpdateType &&update) {
+	++_stats.delivered;
+
+	// Subscribers may come and go from the handlers, so after any change
+	// of the list we look for the next one by the id of the current one.
+	// The ones subscribed from the handlers don't get this update.
+	const auto value = update.flags.value();
+	const auto subscribers = _subscribers;
+	const auto last = subscribers->lastId;
+	auto &list = subscribers->list;
+	for (auto i = list.begin(); i != list.end() && i->first <= last;) {
+		if (!(i->second.mask & value)) {
+			++i;
+			continue;
+		}
+		const auto id = i->first;
+		const auto version = subscribers->version;
+		i->second.stream.fire_copy(update);
+		if (subscribers->version == version) {
+			++i;
+		} else {
+			i = list.upper_bound(id);
+		}
+	}
+}
+
+template <typename DataType, typename UpdateType>
+rpl::producer<UpdateType> Changes::Manager<DataType, UpdateType>::events(
+		Flags flags) const {
+	const auto mask = flags.value();
+	const auto weak = std::weak_ptr<Subscribers>(_subscribers);
+	return [=](auto consumer) {
+		const auto strong = weak.lock();
+		if (!strong) {
+			return rpl::lifetime();
+		}
+		const auto id = ++strong->lastId;
+		auto &subscriber = strong->list[id];
+		subscriber.mask = mask;
+		++strong->version;
+
+		auto result = subscriber.stream.events().start_existing(consumer);
+		result.add([=] {
+			if (const auto strong = weak.lock()) {
+				if (strong->list.erase(id)) {
+					++strong->version;
+				}
+			}
+		});
+		return result;
+	};
+}
+
 template <typename DataType, typename UpdateType>
 void Changes::Manager<DataType, UpdateType>::sendRealtimeNotifications(
 		not_null<DataType*> data,
@@ -44,20 +104,18 @@ void Changes::Manager<DataType, UpdateType>::sendRealtimeNotifications(
 template <typename DataType, typename UpdateType>
 rpl::producer<UpdateType> Changes::Manager<DataType, UpdateType>::updates(
 		Flags flags) const {
-	return _stream.events(
-	) | rpl::filter([=](const UpdateType &update) {
-		return (update.flags & flags);
-	});
+	return events(flags);
 }
 
 template <typename DataType, typename UpdateType>
 rpl::producer<UpdateType> Changes::Manager<DataType, UpdateType>::updates(
 		not_null<DataType*> data,
 		Flags flags) const {
-	return _stream.events(
+	return events(
+		flags
 	) | rpl::filter([=](const UpdateType &update) {
-		const auto [updateData, updateFlags] = update;
-		return (updateData == data) && (updateFlags & flags);
+		const auto &[updateData, updateFlags] = update;
+		return (updateData == data);
 	});
 }
 
@@ -79,11 +137,21 @@ rpl::producer<UpdateType> Changes::Manager<DataType, UpdateType>::flagsValue(
 template <typename DataType, typename UpdateType>
 void Changes::Manager<DataType, UpdateType>::sendNotifications() {
 	for (const auto &[data, flags] : base::take(_updates)) {
-		_stream.fire({ data, flags });
+		send({ data, flags });
 	}
 }
 
-Changes::Changes(not_null<Main::Session*> session) : _session(session) {
+template <typename DataType, typename UpdateType>
+void Changes::Manager<DataType, UpdateType>::appendStats(
+		ChangesStats &stats) const {
+	stats.fired += _stats.fired;
+	stats.delivered += _stats.delivered;
+}
+
+Changes::Changes(not_null<Main::Session*> session)
+: _session(session)
+, _statsTimer([=] { logStats(); }) {
+	_statsTimer.callEach(kLogStatsTimeout);
 }
 
 Main::Session &Changes::session() const {
@@ -234,7 +302,7 @@ void Changes::scheduleNotifications() {
 }
 
 void Changes::sendNotifications() {
-	if (!_notify) {
+	if (!_notify || _batchDepth > 0) {
 		return;
 	}
 	_notify = false;
@@ -244,4 +312,39 @@ void Changes::sendNotifications() {
 	_entryChanges.sendNotifications();
 }
 
+ChangesStats Changes::stats() const {
+	auto result = ChangesStats();
+	_peerChanges.appendStats(result);
+	_historyChanges.appendStats(result);
+	_messageChanges.appendStats(result);
+	_entryChanges.appendStats(result);
+	return result;
+}
+
+void Changes::logStats() {
+	const auto now = stats();
+	if (now.fired == _statsLogged.fired) {
+		return;
+	}
+	LOG(("Changes Info: %1 updates fired, %2 delivered after merging "
+		"(%3 and %4 in total)."
+		).arg(now.fired - _statsLogged.fired
+		).arg(now.delivered - _statsLogged.delivered
+		).arg(now.fired
+		).arg(now.delivered));
+	_statsLogged = now;
+}
+
+void Changes::startBatch() {
+	++_batchDepth;
+}
+
+void Changes::finishBatch() {
+	Expects(_batchDepth > 0);
+
+	if (!--_batchDepth) {
+		sendNotifications();
+	}
+}
+
 } // namespace Data
@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "base/flags.h"
+#include "base/timer.h"
 
 class History;
 class PeerData;
@@ -180,6 +181,11 @@ struct EntryUpdate {
 
 };
 
+struct ChangesStats {
+	uint64 fired = 0; // Calls of *Updated() methods.
+	uint64 delivered = 0; // Merged updates actually sent to subscribers.
+};
+
 class Changes final {
 public:
 	explicit Changes(not_null<Main::Session*> session);
@@ -249,6 +255,12 @@ public:
 
 	void sendNotifications();
 
+	// Non-realtime notifications are held until the last batch finishes.
+	void startBatch();
+	void finishBatch();
+
+	[[nodiscard]] ChangesStats stats() const;
+
 private:
 	template <typename DataType, typename UpdateType>
 	class Manager final {
@@ -272,20 +284,41 @@ private:
 
 		void sendNotifications();
 
+		void appendStats(ChangesStats &stats) const;
+
 	private:
 		static constexpr auto kCount = details::CountBit<Flag>() + 1;
 
 		void sendRealtimeNotifications(
 			not_null<DataType*> data,
 			Flags flags);
+		void send(UpdateType &&update);
+
+		struct Subscriber {
+			typename Flags::Type mask = 0;
+			rpl::event_stream<UpdateType> stream;
+		};
+		struct Subscribers {
+			std::map<uint64, Subscriber> list; // By subscription order.
+			uint64 lastId = 0;
+			uint64 version = 0; // Changes when the list changes.
+		};
+
+		// Every subscriber has its own stream with the flags it wants,
+		// so it doesn't wake up for updates it would filter out, and
+		// the updates are still delivered in the subscription order.
+		[[nodiscard]] rpl::producer<UpdateType> events(Flags flags) const;
 
 		std::array<rpl::event_stream<UpdateType>, kCount> _realtimeStreams;
 		base::flat_map<not_null<DataType*>, Flags> _updates;
-		rpl::event_stream<UpdateType> _stream;
+		const std::shared_ptr<Subscribers> _subscribers
+			= std::make_shared<Subscribers>();
+		ChangesStats _stats;
 
 	};
 
 	void scheduleNotifications();
+	void logStats();
 
 	const not_null<Main::Session*> _session;
 
@@ -295,8 +328,12 @@ private:
 	Manager<HistoryItem, MessageUpdate> _messageChanges;
 	Manager<Dialogs::Entry, EntryUpdate> _entryChanges;
 
+	int _batchDepth = 0;
 	bool _notify = false;
 
+	base::Timer _statsTimer;
+	ChangesStats _statsLogged;
+
 };
 
 } // namespace Data
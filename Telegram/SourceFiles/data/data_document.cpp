@@ -26,6 +26,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "media/streaming/media_streaming_loader_local.h"
 #include "storage/localstorage.h"
 #include "storage/storage_account.h"
+#include "storage/storage_cache_dedup.h"
 #include "storage/streamed_file_downloader.h"
 #include "storage/file_download_mtproto.h"
 #include "storage/file_download_web.h"
@@ -452,7 +453,7 @@ void DocumentData::setDataAndCache(const QByteArray &data) {
 		media->setBytes(data);
 	}
 	if (saveToCache() && data.size() <= Storage::kMaxFileInMemory) {
-		owner().cache().put(
+		owner().cacheDedup().put(
 			cacheKey(),
 			Storage::Cache::Database::TaggedValue(
 				base::duplicate(data),
@@ -560,6 +561,12 @@ bool DocumentData::thumbnailLoading() const {
 	return _thumbnail.loader != nullptr;
 }
 
+void DocumentData::cancelThumbnailLoad() {
+	if (_thumbnail.loader && !activeMediaView()) {
+		_thumbnail.loader->cancel();
+	}
+}
+
 bool DocumentData::thumbnailFailed() const {
 	return (_thumbnail.flags & Data::CloudFile::Flag::Failed);
 }
@@ -182,6 +182,7 @@ public:
 	[[nodiscard]] bool thumbnailLoading() const;
 	[[nodiscard]] bool thumbnailFailed() const;
 	void loadThumbnail(Data::FileOrigin origin);
+	void cancelThumbnailLoad(); // If nobody else is waiting for it.
 	[[nodiscard]] const ImageLocation &thumbnailLocation() const;
 	[[nodiscard]] int thumbnailByteSize() const;
 
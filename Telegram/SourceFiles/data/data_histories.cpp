@@ -11,6 +11,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_channel.h"
 #include "data/data_chat.h"
 #include "data/data_folder.h"
+#include "data/data_histories_memory.h"
 #include "data/data_scheduled_messages.h"
 #include "base/unixtime.h"
 #include "main/main_session.h"
@@ -30,9 +31,12 @@ constexpr auto kReadRequestTimeout = 3 * crl::time(1000);
 
 Histories::Histories(not_null<Session*> owner)
 : _owner(owner)
+, _memory(std::make_unique<HistoriesMemory>(owner))
 , _readRequestsTimer([=] { sendReadRequests(); }) {
 }
 
+Histories::~Histories() = default;
+
 Session &Histories::owner() const {
 	return *_owner;
 }
@@ -41,6 +45,10 @@ Main::Session &Histories::session() const {
 	return _owner->session();
 }
 
+HistoriesMemory &Histories::memory() const {
+	return *_memory;
+}
+
 History *Histories::find(PeerId peerId) {
 	const auto i = peerId ? _map.find(peerId) : end(_map);
 	return (i != end(_map)) ? i->second.get() : nullptr;
@@ -65,6 +73,7 @@ void Histories::unloadAll() {
 }
 
 void Histories::clearAll() {
+	_memory->clear();
 	_map.clear();
 }
 
@@ -20,6 +20,7 @@ namespace Data {
 
 class Session;
 class Folder;
+class HistoriesMemory;
 
 class Histories final {
 public:
@@ -32,9 +33,11 @@ public:
 	};
 
 	explicit Histories(not_null<Session*> owner);
+	~Histories();
 
 	[[nodiscard]] Session &owner() const;
 	[[nodiscard]] Main::Session &session() const;
+	[[nodiscard]] HistoriesMemory &memory() const;
 
 	[[nodiscard]] History *find(PeerId peerId);
 	[[nodiscard]] not_null<History*> findOrCreate(PeerId peerId);
@@ -132,6 +135,7 @@ private:
 	const not_null<Session*> _owner;
 
 	std::unordered_map<PeerId, std::unique_ptr<History>> _map;
+	const std::unique_ptr<HistoriesMemory> _memory;
 	base::flat_map<not_null<History*>, State> _states;
 	base::flat_map<int, not_null<History*>> _historyByRequest;
 	int _requestAutoincrement = 0;
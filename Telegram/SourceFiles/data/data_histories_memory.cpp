@@ -0,0 +1,134 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "data/data_histories_memory.h"
+
+#include "core/application.h"
+#include "core/core_settings.h"
+#include "data/data_session.h"
+#include "history/history.h"
+#include "history/history_item.h"
+#include "history/view/history_view_element.h"
+#include "main/main_session.h"
+#include "window/window_session_controller.h"
+
+namespace Data {
+namespace {
+
+constexpr auto kCheckTimeout = 15 * crl::time(1000);
+constexpr auto kColdTimeout = 30 * 60 * crl::time(1000);
+
+// Rough cost of a view with its layout, links and text cache.
+constexpr auto kElementSize = int64(2048);
+
+// The view keeps its own copy of the text together with the layout
+// blocks, the item text itself stays in memory after unloading.
+constexpr auto kTextCharSize = int64(sizeof(QChar) + 6);
+constexpr auto kHeavyPartSize = int64(256 * 1024);
+
+} // namespace
+
+HistoriesMemory::HistoriesMemory(not_null<Session*> owner)
+: _owner(owner)
+, _checkTimer([=] { check(); }) {
+	_checkTimer.callEach(kCheckTimeout);
+
+	Core::App().settings().historiesMemoryBudgetChanges(
+	) | rpl::start_with_next([=] {
+		check();
+	}, _lifetime);
+}
+
+void HistoriesMemory::touch(not_null<History*> history) {
+	_lastAccess[history] = crl::now();
+}
+
+void HistoriesMemory::clear() {
+	_lastAccess.clear();
+	_usage = 0;
+}
+
+int64 HistoriesMemory::usage() const {
+	return _usage.current();
+}
+
+rpl::producer<int64> HistoriesMemory::usageValue() const {
+	return _usage.value();
+}
+
+int64 HistoriesMemory::estimate(not_null<History*> history) const {
+	auto result = int64();
+	for (const auto &block : history->blocks) {
+		for (const auto &view : block->messages) {
+			result += kElementSize + view->text().length() * kTextCharSize;
+			if (view->hasHeavyPart()) {
+				result += kHeavyPartSize;
+			}
+		}
+	}
+	return result;
+}
+
+base::flat_set<not_null<History*>> HistoriesMemory::collectShown() const {
+	auto result = base::flat_set<not_null<History*>>();
+	for (const auto &window : _owner->session().windows()) {
+		if (const auto history = window->activeChatCurrent().history()) {
+			result.emplace(history);
+			if (const auto from = history->peer->migrateFrom()) {
+				if (const auto migrated = _owner->historyLoaded(from)) {
+					result.emplace(migrated);
+				}
+			}
+		}
+	}
+	return result;
+}
+
+void HistoriesMemory::check() {
+	struct Entry {
+		not_null<History*> history;
+		crl::time lastAccess = 0;
+		int64 size = 0;
+	};
+	const auto shown = collectShown();
+	auto entries = std::vector<Entry>();
+	entries.reserve(_lastAccess.size());
+	auto total = int64();
+	for (auto i = begin(_lastAccess); i != end(_lastAccess);) {
+		const auto [history, lastAccess] = *i;
+		const auto size = estimate(history);
+		if (!size && !shown.contains(history)) {
+			i = _lastAccess.erase(i);
+			continue;
+		}
+		total += size;
+		if (!shown.contains(history)) {
+			entries.push_back({ history, lastAccess, size });
+		}
+		++i;
+	}
+	const auto megabytes = Core::App().settings().historiesMemoryBudget();
+	const auto budget = int64(megabytes) * 1024 * 1024;
+	if (megabytes > 0 && total > budget) {
+		ranges::sort(entries, ranges::less(), &Entry::lastAccess);
+		const auto now = crl::now();
+		for (const auto &entry : entries) {
+			if (total <= budget || entry.lastAccess + kColdTimeout > now) {
+				break;
+			}
+			DEBUG_LOG(("Histories Memory: Unloading %1 (%2 bytes)."
+				).arg(entry.history->peer->id.value
+				).arg(entry.size));
+			entry.history->clear(History::ClearType::Unload);
+			_lastAccess.remove(entry.history);
+			total -= entry.size;
+		}
+	}
+	_usage = total;
+}
+
+} // namespace Data
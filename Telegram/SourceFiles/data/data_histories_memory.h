@@ -0,0 +1,45 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/timer.h"
+
+class History;
+
+namespace Data {
+
+class Session;
+
+// Keeps the memory used by the views of loaded histories under a budget
+// by unloading the chats that were not opened for the longest time.
+class HistoriesMemory final {
+public:
+	explicit HistoriesMemory(not_null<Session*> owner);
+
+	void touch(not_null<History*> history);
+	void clear();
+
+	[[nodiscard]] int64 usage() const;
+	[[nodiscard]] rpl::producer<int64> usageValue() const;
+
+private:
+	void check();
+	[[nodiscard]] int64 estimate(not_null<History*> history) const;
+	[[nodiscard]] base::flat_set<not_null<History*>> collectShown() const;
+
+	const not_null<Session*> _owner;
+
+	base::flat_map<not_null<History*>, crl::time> _lastAccess;
+	rpl::variable<int64> _usage = 0;
+	base::Timer _checkTimer;
+
+	rpl::lifetime _lifetime;
+
+};
+
+} // namespace Data
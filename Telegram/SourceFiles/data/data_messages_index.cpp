@@ -0,0 +1,178 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "data/data_messages_index.h"
+
+#include "data/data_peer.h"
+#include "history/history.h"
+#include "history/history_item.h"
+#include "ui/text/text_entity.h"
+
+namespace Data {
+namespace {
+
+[[nodiscard]] std::vector<QString> ItemWords(
+		not_null<HistoryItem*> item) {
+	const auto text = item->originalText().text;
+	if (text.isEmpty()) {
+		return {};
+	}
+	const auto words = TextUtilities::PrepareSearchWords(text);
+	auto result = std::vector<QString>(words.begin(), words.end());
+	ranges::sort(result);
+	result.erase(ranges::unique(result), end(result));
+	return result;
+}
+
+} // namespace
+
+void MessagesIndex::add(not_null<HistoryItem*> item) {
+	if (!item->isRegular()) {
+		return;
+	} else if (_items.contains(item)) {
+		refresh(item);
+		return;
+	}
+	auto words = ItemWords(item);
+	addWords(item, words);
+	_items[item] = std::move(words);
+}
+
+void MessagesIndex::refresh(not_null<HistoryItem*> item) {
+	const auto i = _items.find(item);
+	if (i == end(_items)) {
+		return;
+	}
+	auto words = ItemWords(item);
+	if (words == i->second) {
+		return;
+	}
+	removeWords(item, i->second);
+	addWords(item, words);
+	i->second = std::move(words);
+}
+
+void MessagesIndex::remove(not_null<HistoryItem*> item) {
+	const auto i = _items.find(item);
+	if (i == end(_items)) {
+		return;
+	}
+	removeWords(item, i->second);
+	_items.erase(i);
+}
+
+void MessagesIndex::clear() {
+	_words.clear();
+	_items.clear();
+}
+
+int MessagesIndex::indexedCount() const {
+	return int(_items.size());
+}
+
+void MessagesIndex::addWords(
+		not_null<HistoryItem*> item,
+		const std::vector<QString> &words) {
+	if (words.empty()) {
+		return;
+	}
+	auto &index = _words[item->history()->peer->id];
+	for (const auto &word : words) {
+		index[word].emplace(item);
+	}
+}
+
+void MessagesIndex::removeWords(
+		not_null<HistoryItem*> item,
+		const std::vector<QString> &words) {
+	if (words.empty()) {
+		return;
+	}
+	const auto peerId = item->history()->peer->id;
+	const auto i = _words.find(peerId);
+	if (i == end(_words)) {
+		return;
+	}
+	auto &index = i->second;
+	for (const auto &word : words) {
+		const auto j = index.find(word);
+		if (j != end(index)) {
+			j->second.erase(item);
+			if (j->second.empty()) {
+				index.erase(j);
+			}
+		}
+	}
+	if (index.empty()) {
+		_words.erase(i);
+	}
+}
+
+auto MessagesIndex::collect(
+		const Words &words,
+		const QString &prefix) const -> Items {
+	auto result = Items();
+	for (auto i = words.lower_bound(prefix); i != end(words); ++i) {
+		if (!i->first.startsWith(prefix)) {
+			break;
+		}
+		result.insert(begin(i->second), end(i->second));
+	}
+	return result;
+}
+
+MessageIdsList MessagesIndex::search(
+		not_null<PeerData*> peer,
+		const QString &query,
+		PeerData *from,
+		int limit) const {
+	const auto i = _words.find(peer->id);
+	if (i == end(_words)) {
+		return {};
+	}
+	const auto queryWords = TextUtilities::PrepareSearchWords(query);
+	if (queryWords.isEmpty()) {
+		return {};
+	}
+	auto found = std::optional<Items>();
+	for (const auto &word : queryWords) {
+		auto items = collect(i->second, word);
+		if (found) {
+			for (auto j = begin(*found); j != end(*found);) {
+				if (items.contains(*j)) {
+					++j;
+				} else {
+					j = found->erase(j);
+				}
+			}
+		} else {
+			found = std::move(items);
+		}
+		if (found->empty()) {
+			return {};
+		}
+	}
+	auto items = std::vector<not_null<HistoryItem*>>();
+	items.reserve(found->size());
+	for (const auto &item : *found) {
+		if (item->isRegular() && (!from || item->from() == from)) {
+			items.push_back(item);
+		}
+	}
+	ranges::sort(items, ranges::greater(), &HistoryItem::id);
+	if (limit > 0 && int(items.size()) > limit) {
+		items.resize(limit);
+	}
+	auto result = MessageIdsList();
+	result.reserve(items.size());
+	for (const auto &item : items) {
+		result.push_back(item->fullId());
+	}
+	return result;
+}
+
+} // namespace Data
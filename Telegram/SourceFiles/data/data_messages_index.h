@@ -0,0 +1,54 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+class HistoryItem;
+class PeerData;
+
+namespace Data {
+
+// Inverted index over the text of the regular history messages that are
+// currently in memory. Scheduled, sponsored and local (not yet sent)
+// messages are skipped. Allows showing local search results before the
+// server answers.
+class MessagesIndex final {
+public:
+	void add(not_null<HistoryItem*> item);
+	void refresh(not_null<HistoryItem*> item);
+	void remove(not_null<HistoryItem*> item);
+	void clear();
+
+	[[nodiscard]] MessageIdsList search(
+		not_null<PeerData*> peer,
+		const QString &query,
+		PeerData *from = nullptr,
+		int limit = 0) const;
+
+	[[nodiscard]] int indexedCount() const;
+
+private:
+	using Items = std::set<not_null<HistoryItem*>>;
+	using Words = std::map<QString, Items>;
+
+	void addWords(
+		not_null<HistoryItem*> item,
+		const std::vector<QString> &words);
+	void removeWords(
+		not_null<HistoryItem*> item,
+		const std::vector<QString> &words);
+
+	[[nodiscard]] Items collect(
+		const Words &words,
+		const QString &prefix) const;
+
+	std::unordered_map<PeerId, Words> _words;
+	std::unordered_map<not_null<HistoryItem*>, std::vector<QString>> _items;
+
+};
+
+} // namespace Data
@@ -17,6 +17,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_file_origin.h"
 #include "data/data_histories.h"
 #include "data/data_cloud_themes.h"
+#include "data/data_userpics_atlas.h"
 #include "base/unixtime.h"
 #include "base/crc32hash.h"
 #include "lang/lang_keys.h"
@@ -305,14 +306,31 @@ void PeerData::paintUserpic(
 		int x,
 		int y,
 		int size) const {
-	if (const auto userpic = currentUserpic(view)) {
+	auto &atlas = owner().userpicsAtlas();
+	const auto cloud = !_userpic.empty() && !isNotificationsUser();
+	const auto cloudKey = cloud
+		? inMemoryKey(_userpic.location())
+		: InMemoryKey();
+	if (cloud && atlas.paint(p, x, y, cloudKey, size)) {
+		return;
+	} else if (const auto userpic = currentUserpic(view)) {
 		const auto circled = Images::Option::RoundCircle;
 		p.drawPixmap(
 			x,
 			y,
 			userpic->pix(size, size, { .options = circled }));
-	} else {
-		ensureEmptyUserpic()->paint(p, x, y, x + size + x, size);
+		if (cloud) {
+			atlas.prepare(cloudKey, size, userpic->original());
+		}
+		return;
+	}
+	const auto empty = ensureEmptyUserpic();
+	const auto emptyKey = empty->uniqueKey();
+	atlas.generate(emptyKey, size, [&](QPainter &q) {
+		empty->paint(q, 0, 0, size, size);
+	});
+	if (!atlas.paint(p, x, y, emptyKey, size)) {
+		empty->paint(p, x, y, x + size + x, size);
 	}
 }
 
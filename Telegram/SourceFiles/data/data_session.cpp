@@ -32,6 +32,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/view/history_view_element.h"
 #include "inline_bots/inline_bot_layout_item.h"
 #include "storage/storage_account.h"
+#include "storage/storage_cache_analytics.h"
+#include "storage/storage_cache_dedup.h"
 #include "storage/storage_encrypted_file.h"
 #include "media/player/media_player_instance.h" // instance()->play()
 #include "media/audio/media_audio.h"
@@ -64,6 +66,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_cloud_themes.h"
 #include "data/data_streaming.h"
 #include "data/data_media_rotation.h"
+#include "data/data_messages_index.h"
+#include "data/data_userpics_atlas.h"
 #include "data/data_histories.h"
 #include "data/data_peer_values.h"
 #include "data/data_premium_limits.h"
@@ -255,9 +259,17 @@ Session::Session(not_null<Main::Session*> session)
 , _reactions(std::make_unique<Reactions>(this))
 , _emojiStatuses(std::make_unique<EmojiStatuses>(this))
 , _notifySettings(std::make_unique<NotifySettings>(this))
-, _customEmojiManager(std::make_unique<CustomEmojiManager>(this)) {
+, _customEmojiManager(std::make_unique<CustomEmojiManager>(this))
+, _messagesIndex(std::make_unique<MessagesIndex>())
+, _userpicsAtlas(std::make_unique<UserpicsAtlas>()) {
 	_cache->open(_session->local().cacheKey());
 	_bigFileCache->open(_session->local().cacheBigFileKey());
+	_cacheAnalytics = std::make_unique<Storage::CacheAnalytics>(
+		_cache.get(),
+		[=] { return _session->local().cacheSettings().totalSizeLimit; });
+	_cacheDedup = std::make_unique<Storage::CacheDedup>(
+		_cache.get(),
+		_cacheAnalytics.get());
 
 	if constexpr (Platform::IsLinux()) {
 		const auto wasVersion = _session->local().oldMapVersion();
@@ -313,6 +325,8 @@ void Session::clear() {
 	_dependentMessages.clear();
 	base::take(_messages);
 	base::take(_nonChannelMessages);
+	_messagesIndex->clear();
+	_userpicsAtlas->clear();
 	_messageByRandomId.clear();
 	_sentMessagesData.clear();
 	cSetRecentInlineBots(RecentInlineBots());
@@ -1092,6 +1106,14 @@ Storage::Cache::Database &Session::cacheBigFile() {
 	return *_bigFileCache;
 }
 
+Storage::CacheAnalytics &Session::cacheAnalytics() {
+	return *_cacheAnalytics;
+}
+
+Storage::CacheDedup &Session::cacheDedup() {
+	return *_cacheDedup;
+}
+
 void Session::suggestStartExport(TimeId availableAt) {
 	_exportAvailableAt = availableAt;
 	suggestStartExport();
@@ -1431,6 +1453,9 @@ void Session::notifyItemIdChange(IdChange event) {
 	const auto item = event.item;
 	changeMessageId(item->history()->peer->id, event.oldId, item->id);
 
+	// Sent messages become regular only when they get the real id.
+	_messagesIndex->add(item);
+
 	_itemIdChanges.fire_copy(event);
 
 	const auto refreshViewDataId = [](not_null<ViewElement*> view) {
@@ -2030,6 +2055,7 @@ void Session::registerMessage(not_null<HistoryItem*> item) {
 		i->second->destroy();
 	}
 	list->emplace(itemId, item);
+	_messagesIndex->add(item);
 
 	if (!peerIsChannel(peerId) && IsServerMsgId(itemId)) {
 		_nonChannelMessages.emplace(itemId, item);
@@ -2152,6 +2178,7 @@ void Session::unregisterMessage(not_null<HistoryItem*> item) {
 		Data::MessageUpdate::Flag::Destroyed);
 	groups().unregisterMessage(item);
 	removeDependencyMessage(item);
+	_messagesIndex->remove(item);
 	messagesListForInsert(peerId)->erase(itemId);
 
 	if (!peerIsChannel(peerId) && IsServerMsgId(itemId)) {
@@ -2334,6 +2361,10 @@ rpl::producer<> Session::unreadBadgeChanges() const {
 }
 
 void Session::notifyUnreadBadgeChanged() {
+	if (_updatesBatchDepth > 0) {
+		_unreadBadgeChangePending = true;
+		return;
+	}
 	_unreadBadgeChanges.fire({});
 }
 
@@ -3783,6 +3814,10 @@ void Session::refreshChatListEntry(Dialogs::Key key) {
 	using namespace Dialogs;
 
 	const auto entry = key.entry();
+	if (_updatesBatchDepth > 0 && entry->inChatList()) {
+		_chatListEntriesToRefresh.emplace(key);
+		return;
+	}
 	const auto history = key.history();
 	const auto mainList = chatsList(entry->folder());
 	auto event = ChatListEntryRefresh{ .key = key };
@@ -3834,6 +3869,7 @@ void Session::refreshChatListEntry(Dialogs::Key key) {
 void Session::removeChatListEntry(Dialogs::Key key) {
 	using namespace Dialogs;
 
+	_chatListEntriesToRefresh.remove(key);
 	const auto entry = key.entry();
 	if (!entry->inChatList()) {
 		return;
@@ -3871,6 +3907,29 @@ auto Session::chatListEntryRefreshes() const
 	return _chatListEntryRefreshes.events();
 }
 
+void Session::startUpdatesBatch() {
+	if (!_updatesBatchDepth++) {
+		session().changes().startBatch();
+	}
+}
+
+void Session::finishUpdatesBatch() {
+	Expects(_updatesBatchDepth > 0);
+
+	if (--_updatesBatchDepth > 0) {
+		return;
+	}
+	for (const auto &key : base::take(_chatListEntriesToRefresh)) {
+		if (key.entry()->inChatList()) {
+			refreshChatListEntry(key);
+		}
+	}
+	if (base::take(_unreadBadgeChangePending)) {
+		notifyUnreadBadgeChanged();
+	}
+	sendHistoryChangeNotifications();
+	session().changes().finishBatch();
+}
 
 void Session::dialogsRowReplaced(DialogsRowReplacement replacement) {
 	_dialogsRowReplacements.fire(std::move(replacement));
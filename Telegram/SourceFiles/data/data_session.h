@@ -39,6 +39,11 @@ namespace Ui {
 class BoxContent;
 } // namespace Ui
 
+namespace Storage {
+class CacheAnalytics;
+class CacheDedup;
+} // namespace Storage
+
 namespace Passport {
 struct SavedCredentials;
 } // namespace Passport
@@ -64,6 +69,8 @@ class Stickers;
 class GroupCall;
 class NotifySettings;
 class CustomEmojiManager;
+class MessagesIndex;
+class UserpicsAtlas;
 
 class Session final {
 public:
@@ -128,6 +135,12 @@ public:
 	[[nodiscard]] CustomEmojiManager &customEmojiManager() const {
 		return *_customEmojiManager;
 	}
+	[[nodiscard]] MessagesIndex &messagesIndex() const {
+		return *_messagesIndex;
+	}
+	[[nodiscard]] UserpicsAtlas &userpicsAtlas() const {
+		return *_userpicsAtlas;
+	}
 
 	[[nodiscard]] MsgId nextNonHistoryEntryId() {
 		return ++_nonHistoryEntryId;
@@ -150,6 +163,8 @@ public:
 
 	[[nodiscard]] Storage::Cache::Database &cache();
 	[[nodiscard]] Storage::Cache::Database &cacheBigFile();
+	[[nodiscard]] Storage::CacheAnalytics &cacheAnalytics();
+	[[nodiscard]] Storage::CacheDedup &cacheDedup();
 
 	[[nodiscard]] not_null<PeerData*> peer(PeerId id);
 	[[nodiscard]] not_null<PeerData*> peer(UserId id) = delete;
@@ -669,6 +684,11 @@ public:
 	[[nodiscard]] auto chatListEntryRefreshes() const
 		-> rpl::producer<ChatListEntryRefresh>;
 
+	// While a batch is active chat list reordering of existing entries
+	// and unread badge notifications are deferred until it is finished.
+	void startUpdatesBatch();
+	void finishUpdatesBatch();
+
 	struct DialogsRowReplacement {
 		not_null<Dialogs::Row*> old;
 		Dialogs::Row *now = nullptr;
@@ -830,6 +850,8 @@ private:
 
 	Storage::DatabasePointer _cache;
 	Storage::DatabasePointer _bigFileCache;
+	std::unique_ptr<Storage::CacheAnalytics> _cacheAnalytics;
+	std::unique_ptr<Storage::CacheDedup> _cacheDedup;
 
 	TimeId _exportAvailableAt = 0;
 	QPointer<Ui::BoxContent> _exportSuggestion;
@@ -865,6 +887,10 @@ private:
 	rpl::event_stream<> _unreadBadgeChanges;
 	rpl::event_stream<UnreadRepliesCountRequest> _unreadRepliesCountRequests;
 
+	int _updatesBatchDepth = 0;
+	base::flat_set<Dialogs::Key> _chatListEntriesToRefresh;
+	bool _unreadBadgeChangePending = false;
+
 	Dialogs::MainList _chatsList;
 	Dialogs::IndexedList _contactsList;
 	Dialogs::IndexedList _contactsNoChatsList;
@@ -987,6 +1013,8 @@ private:
 	const std::unique_ptr<EmojiStatuses> _emojiStatuses;
 	const std::unique_ptr<NotifySettings> _notifySettings;
 	const std::unique_ptr<CustomEmojiManager> _customEmojiManager;
+	const std::unique_ptr<MessagesIndex> _messagesIndex;
+	const std::unique_ptr<UserpicsAtlas> _userpicsAtlas;
 
 	MsgId _nonHistoryEntryId = ServerMaxMsgId.bare + ScheduledMsgIdsRange;
 
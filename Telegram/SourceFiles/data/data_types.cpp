@@ -22,6 +22,7 @@ constexpr auto kAudioAlbumThumbCacheTag = 0x0000000000000300ULL;
 constexpr auto kWebDocumentCacheTag = 0x0000020000000000ULL;
 constexpr auto kUrlCacheTag = 0x0000030000000000ULL;
 constexpr auto kGeoPointCacheTag = 0x0000040000000000ULL;
+constexpr auto kContentCacheTag = 0x0000050000000000ULL;
 
 } // namespace
 
@@ -95,6 +96,35 @@ Storage::Cache::Key AudioAlbumThumbCacheKey(
 	};
 }
 
+Storage::Cache::Key ContentCacheKey(bytes::const_span hash) {
+	Expects(hash.size() >= sizeof(uint32) + sizeof(uint64) + sizeof(uint16));
+
+	const auto bytes1 = hash.subspan(0, sizeof(uint32));
+	const auto bytes2 = hash.subspan(sizeof(uint32), sizeof(uint64));
+	const auto bytes3 = hash.subspan(
+		sizeof(uint32) + sizeof(uint64),
+		sizeof(uint16));
+	const auto part1 = *reinterpret_cast<const uint32*>(bytes1.data());
+	const auto part2 = *reinterpret_cast<const uint64*>(bytes2.data());
+	const auto part3 = *reinterpret_cast<const uint16*>(bytes3.data());
+	return Storage::Cache::Key{
+		Data::kContentCacheTag | (uint64(part3) << 32) | part1,
+		part2
+	};
+}
+
+Storage::Cache::Key ContentCacheStatsKey() {
+	return Storage::Cache::Key{ Data::kContentCacheTag, 0 };
+}
+
+Storage::Cache::Key CacheAnalyticsKey() {
+	return Storage::Cache::Key{ Data::kContentCacheTag, 1 };
+}
+
+Storage::Cache::Key CacheHitsKey() {
+	return Storage::Cache::Key{ Data::kContentCacheTag, 2 };
+}
+
 } // namespace Data
 
 void MessageCursor::fillFrom(not_null<const Ui::InputField*> field) {
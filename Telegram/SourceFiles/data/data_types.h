@@ -51,6 +51,10 @@ Storage::Cache::Key UrlCacheKey(const QString &location);
 Storage::Cache::Key GeoPointCacheKey(const GeoPointLocation &location);
 Storage::Cache::Key AudioAlbumThumbCacheKey(
 	const AudioAlbumThumbLocation &location);
+Storage::Cache::Key ContentCacheKey(bytes::const_span hash);
+Storage::Cache::Key ContentCacheStatsKey();
+Storage::Cache::Key CacheAnalyticsKey();
+Storage::Cache::Key CacheHitsKey();
 
 constexpr auto kImageCacheTag = uint8(0x01);
 constexpr auto kStickerCacheTag = uint8(0x02);
@@ -0,0 +1,256 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "data/data_userpics_atlas.h"
+
+#include "ui/image/image_prepare.h"
+#include "styles/style_basic.h"
+
+#include <list>
+
+namespace Data {
+namespace {
+
+constexpr auto kPageSide = 1024;
+constexpr auto kMemoryLimit = int64(48 * 1024 * 1024);
+
+} // namespace
+
+struct UserpicsAtlas::Page {
+	QPixmap pixmap; // Null if the page was released.
+	uint64 usedAt = 0;
+};
+
+struct UserpicsAtlas::Group {
+	int size = 0;
+	int perSide = 0;
+	std::vector<Page> pages;
+	std::vector<std::pair<int, int>> free;
+	std::list<Key> lru; // Least recently used first.
+};
+
+struct UserpicsAtlas::Entry {
+	int page = 0;
+	int slot = 0;
+	std::list<Key>::iterator lru;
+};
+
+UserpicsAtlas::UserpicsAtlas() {
+	style::PaletteChanged(
+	) | rpl::start_with_next([=] {
+		// Empty userpics are painted with palette colors.
+		clear();
+	}, _lifetime);
+}
+
+UserpicsAtlas::~UserpicsAtlas() = default;
+
+bool UserpicsAtlas::paint(
+		QPainter &p,
+		int x,
+		int y,
+		InMemoryKey key,
+		int size) {
+	const auto deviceSize = size * style::DevicePixelRatio();
+	const auto i = _entries.find(Key{ key, deviceSize });
+	if (i == end(_entries)) {
+		return false;
+	}
+	const auto entry = &i->second;
+	const auto group = &this->group(deviceSize);
+	touch(entry, group);
+
+	const auto column = entry->slot % group->perSide;
+	const auto row = entry->slot / group->perSide;
+	p.drawPixmap(
+		QRect(x, y, size, size),
+		group->pages[entry->page].pixmap,
+		QRect(column * deviceSize, row * deviceSize, deviceSize, deviceSize));
+	return true;
+}
+
+void UserpicsAtlas::prepare(InMemoryKey key, int size, QImage original) {
+	const auto deviceSize = size * style::DevicePixelRatio();
+	const auto full = Key{ key, deviceSize };
+	if (_entries.contains(full) || _preparing.contains(full)) {
+		return;
+	}
+	_preparing.emplace(full);
+	crl::async([
+		=,
+		weak = base::make_weak(this),
+		original = std::move(original)
+	]() mutable {
+		auto result = Images::Prepare(
+			std::move(original),
+			deviceSize,
+			deviceSize,
+			{ .options = Images::Option::RoundCircle });
+		crl::on_main(weak, [=, result = std::move(result)] {
+			_preparing.remove(full);
+			insert(full, result);
+		});
+	});
+}
+
+void UserpicsAtlas::generate(
+		InMemoryKey key,
+		int size,
+		Fn<void(QPainter&)> paint) {
+	const auto ratio = style::DevicePixelRatio();
+	const auto full = Key{ key, size * ratio };
+	if (_entries.contains(full)) {
+		return;
+	}
+	auto image = QImage(
+		QSize(size, size) * ratio,
+		QImage::Format_ARGB32_Premultiplied);
+	image.setDevicePixelRatio(ratio);
+	image.fill(Qt::transparent);
+	{
+		auto p = QPainter(&image);
+		paint(p);
+	}
+	insert(full, image);
+}
+
+void UserpicsAtlas::clear() {
+	_entries.clear();
+	_groups.clear();
+	_memoryUsage = 0;
+}
+
+int64 UserpicsAtlas::memoryUsage() const {
+	return _memoryUsage;
+}
+
+UserpicsAtlas::Group &UserpicsAtlas::group(int deviceSize) {
+	auto &result = _groups[deviceSize];
+	if (!result) {
+		result = std::make_unique<Group>();
+		result->size = deviceSize;
+		result->perSide = std::max(kPageSide / deviceSize, 1);
+	}
+	return *result;
+}
+
+auto UserpicsAtlas::allocate(Key key, not_null<Group*> group)
+-> not_null<Entry*> {
+	if (group->free.empty()) {
+		const auto side = group->perSide * group->size;
+		const auto bytes = int64(side) * side * 4;
+		if (_memoryUsage + bytes <= kMemoryLimit) {
+			addPage(group);
+		} else if (!group->lru.empty()) {
+			const auto i = _entries.find(group->lru.front());
+			Assert(i != end(_entries));
+			group->free.emplace_back(i->second.page, i->second.slot);
+			group->lru.pop_front();
+			_entries.erase(i);
+		} else {
+			// A size without pages takes them from the other sizes.
+			releaseOldPages(bytes);
+			addPage(group);
+		}
+	}
+	const auto [page, slot] = group->free.back();
+	group->free.pop_back();
+	group->lru.push_back(key);
+	return &_entries.emplace(key, Entry{
+		.page = page,
+		.slot = slot,
+		.lru = std::prev(end(group->lru)),
+	}).first->second;
+}
+
+void UserpicsAtlas::addPage(not_null<Group*> group) {
+	const auto side = group->perSide * group->size;
+	auto pixmap = QPixmap(side, side);
+	pixmap.fill(Qt::transparent);
+	const auto released = ranges::find_if(group->pages, [](const Page &page) {
+		return page.pixmap.isNull();
+	});
+	const auto page = int(released - begin(group->pages));
+	if (released != end(group->pages)) {
+		released->pixmap = std::move(pixmap);
+	} else {
+		group->pages.push_back({ std::move(pixmap) });
+	}
+	_memoryUsage += int64(side) * side * 4;
+
+	const auto count = group->perSide * group->perSide;
+	for (auto slot = count; slot != 0;) {
+		group->free.emplace_back(page, --slot);
+	}
+}
+
+void UserpicsAtlas::releaseOldPages(int64 bytes) {
+	while (_memoryUsage + bytes > kMemoryLimit) {
+		auto oldestGroup = (Group*)nullptr;
+		auto oldestPage = 0;
+		for (const auto &[size, group] : _groups) {
+			for (auto i = 0, count = int(group->pages.size()); i != count; ++i) {
+				const auto &page = group->pages[i];
+				if (page.pixmap.isNull()) {
+					continue;
+				} else if (!oldestGroup
+					|| page.usedAt < oldestGroup->pages[oldestPage].usedAt) {
+					oldestGroup = group.get();
+					oldestPage = i;
+				}
+			}
+		}
+		if (!oldestGroup) {
+			return;
+		}
+		releasePage(oldestGroup, oldestPage);
+	}
+}
+
+void UserpicsAtlas::releasePage(not_null<Group*> group, int page) {
+	for (auto i = begin(group->lru); i != end(group->lru);) {
+		const auto j = _entries.find(*i);
+		Assert(j != end(_entries));
+		if (j->second.page == page) {
+			_entries.erase(j);
+			i = group->lru.erase(i);
+		} else {
+			++i;
+		}
+	}
+	group->free.erase(ranges::remove(
+		group->free,
+		page,
+		&std::pair<int, int>::first), end(group->free));
+
+	const auto side = group->perSide * group->size;
+	group->pages[page].pixmap = QPixmap();
+	_memoryUsage -= int64(side) * side * 4;
+}
+
+void UserpicsAtlas::insert(Key key, const QImage &image) {
+	const auto group = &this->group(key.second);
+	const auto i = _entries.find(key);
+	const auto entry = (i != end(_entries))
+		? not_null<Entry*>(&i->second)
+		: allocate(key, group);
+	touch(entry, group);
+
+	const auto size = group->size;
+	const auto column = entry->slot % group->perSide;
+	const auto row = entry->slot / group->perSide;
+	auto p = QPainter(&group->pages[entry->page].pixmap);
+	p.setCompositionMode(QPainter::CompositionMode_Source);
+	p.drawImage(QRect(column * size, row * size, size, size), image);
+}
+
+void UserpicsAtlas::touch(not_null<Entry*> entry, not_null<Group*> group) {
+	group->lru.splice(end(group->lru), group->lru, entry->lru);
+	group->pages[entry->page].usedAt = ++_lastUsed;
+}
+
+} // namespace Data
@@ -0,0 +1,67 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/weak_ptr.h"
+
+namespace Data {
+
+// Circle userpics of recently painted peers packed into shared pages,
+// one set of pages per device pixel size. Chat lists, member lists and
+// message headers draw from the same slots instead of keeping their own
+// scaled copies, so a userpic is rounded once per size while it stays
+// in the atlas, even after the views holding its image are destroyed.
+class UserpicsAtlas final : public base::has_weak_ptr {
+public:
+	UserpicsAtlas();
+	~UserpicsAtlas();
+
+	[[nodiscard]] bool paint(
+		QPainter &p,
+		int x,
+		int y,
+		InMemoryKey key,
+		int size);
+
+	// Rounds the original on a background thread and adds the result.
+	void prepare(InMemoryKey key, int size, QImage original);
+
+	// Paints the variant right into a slot, for cheap generated images.
+	void generate(InMemoryKey key, int size, Fn<void(QPainter&)> paint);
+
+	void clear();
+
+	[[nodiscard]] int64 memoryUsage() const;
+
+private:
+	struct Page;
+	struct Group;
+	struct Entry;
+	using Key = std::pair<InMemoryKey, int>;
+
+	[[nodiscard]] Group &group(int deviceSize);
+	[[nodiscard]] not_null<Entry*> allocate(
+		Key key,
+		not_null<Group*> group);
+	void addPage(not_null<Group*> group);
+	void releaseOldPages(int64 bytes);
+	void releasePage(not_null<Group*> group, int page);
+	void insert(Key key, const QImage &image);
+	void touch(not_null<Entry*> entry, not_null<Group*> group);
+
+	std::map<Key, Entry> _entries;
+	base::flat_map<int, std::unique_ptr<Group>> _groups;
+	base::flat_set<Key> _preparing;
+	int64 _memoryUsage = 0;
+	uint64 _lastUsed = 0;
+
+	rpl::lifetime _lifetime;
+
+};
+
+} // namespace Data
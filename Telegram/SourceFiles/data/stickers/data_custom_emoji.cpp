@@ -25,6 +25,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/widgets/input_fields.h"
 #include "ui/text/text_custom_emoji.h"
 #include "ui/ui_utility.h"
+#include "core/application.h"
 #include "apiwrap.h"
 #include "styles/style_chat.h"
 #include "styles/style_chat_helpers.h"
@@ -33,9 +34,22 @@ namespace Data {
 namespace {
 
 constexpr auto kMaxPerRequest = 100;
+constexpr auto kRepaintFramePeriod = crl::time(16);
+constexpr auto kRepaintHiddenFramePeriod = crl::time(250);
 
 using SizeTag = CustomEmojiManager::SizeTag;
 
+[[nodiscard]] crl::time RepaintFramePeriod() {
+	return Core::App().animationsHidden()
+		? kRepaintHiddenFramePeriod
+		: kRepaintFramePeriod;
+}
+
+// Repaints due anywhere inside one frame are fired together at its end.
+[[nodiscard]] crl::time RepaintFrameEnd(crl::time when, crl::time period) {
+	return ((when / period) + 1) * period;
+}
+
 [[nodiscard]] ChatHelpers::StickerLottieSize LottieSizeFromTag(SizeTag tag) {
 	// NB! onlyCustomEmoji dimensions caching uses last ::EmojiInteraction-s.
 	using LottieSize = ChatHelpers::StickerLottieSize;
@@ -741,16 +755,15 @@ void CustomEmojiManager::scheduleRepaintTimer() {
 				next = bunch.when;
 			}
 		}
-		if (next && (!_repaintNext || _repaintNext > next)) {
-			const auto now = crl::now();
-			if (now >= next) {
-				_repaintNext = 0;
-				_repaintTimer.cancel();
-				invokeRepaints();
-			} else {
-				_repaintNext = next;
-				_repaintTimer.callOnce(next - now);
-			}
+		if (!next) {
+			return;
+		}
+		const auto now = crl::now();
+		const auto period = RepaintFramePeriod();
+		const auto frame = RepaintFrameEnd(std::max(next, now), period);
+		if (!_repaintNext || _repaintNext > frame) {
+			_repaintNext = frame;
+			_repaintTimer.callOnce(frame - now);
 		}
 	});
 }
@@ -758,9 +771,13 @@ void CustomEmojiManager::scheduleRepaintTimer() {
 void CustomEmojiManager::invokeRepaints() {
 	_repaintNext = 0;
 	const auto now = crl::now();
+	const auto period = RepaintFramePeriod();
+
+	// The timer fires at a frame end, allow it to be a bit early or late.
+	const auto till = RepaintFrameEnd(now - period / 2, period);
 	auto repaint = std::vector<base::weak_ptr<Ui::CustomEmoji::Instance>>();
 	for (auto i = begin(_repaints); i != end(_repaints);) {
-		if (i->second.when > now) {
+		if (i->second.when >= till) {
 			++i;
 			continue;
 		}
@@ -148,6 +148,16 @@ Main::Session &Stickers::session() const {
 	return _owner->session();
 }
 
+void Stickers::setPendingSetsLoader(Fn<void()> loader) {
+	_pendingSetsLoader = std::move(loader);
+}
+
+void Stickers::loadPendingSets() {
+	if (const auto loader = base::take(_pendingSetsLoader)) {
+		loader();
+	}
+}
+
 void Stickers::notifyUpdated(StickersType type) {
 	_updated.fire_copy(type);
 }
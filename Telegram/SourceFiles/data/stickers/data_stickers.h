@@ -148,6 +148,15 @@ public:
 		return _sets;
 	}
 	StickersSets &setsRef() {
+		loadPendingSets();
+		return _sets;
+	}
+
+	// Local storage may postpone reading stickers of some sets,
+	// those are read on the first setsRef() or loadPendingSets() call.
+	void setPendingSetsLoader(Fn<void()> loader);
+	void loadPendingSets();
+	StickersSets &setsRefWithoutPending() {
 		return _sets;
 	}
 	const StickersSetsOrder &setsOrder() const {
@@ -305,6 +314,7 @@ private:
 	crl::time _lastFeaturedEmojiUpdate = 0;
 	crl::time _lastRecentAttachedUpdate = 0;
 	rpl::variable<int> _featuredSetsUnreadCount = 0;
+	Fn<void()> _pendingSetsLoader;
 	StickersSets _sets;
 	StickersSetsOrder _setsOrder;
 	StickersSetsOrder _maskSetsOrder;
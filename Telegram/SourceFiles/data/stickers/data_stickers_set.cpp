@@ -131,6 +131,12 @@ bool StickersSet::thumbnailLoading() const {
 	return (_thumbnail.loader != nullptr);
 }
 
+void StickersSet::cancelThumbnailLoad() {
+	if (_thumbnail.loader && !activeThumbnailView()) {
+		_thumbnail.loader->cancel();
+	}
+}
+
 bool StickersSet::thumbnailFailed() const {
 	return (_thumbnail.flags & Data::CloudFile::Flag::Failed);
 }
@@ -91,6 +91,7 @@ public:
 	[[nodiscard]] bool thumbnailLoading() const;
 	[[nodiscard]] bool thumbnailFailed() const;
 	void loadThumbnail();
+	void cancelThumbnailLoad(); // If nobody else is waiting for it.
 	[[nodiscard]] const ImageLocation &thumbnailLocation() const;
 	[[nodiscard]] Storage::Cache::Key thumbnailBigFileBaseCacheKey() const;
 	[[nodiscard]] int thumbnailByteSize() const;
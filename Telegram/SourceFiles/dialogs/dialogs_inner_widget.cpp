@@ -16,6 +16,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/history_item.h"
 #include "core/shortcuts.h"
 #include "core/application.h"
+#include "core/core_trace.h"
 #include "ui/widgets/buttons.h"
 #include "ui/widgets/popup_menu.h"
 #include "ui/text/text_utilities.h"
@@ -409,6 +410,13 @@ void InnerWidget::changeOpenedFolder(Data::Folder *folder) {
 }
 
 void InnerWidget::paintEvent(QPaintEvent *e) {
+	TRACE_ZONE("Dialogs::InnerWidget::paintEvent");
+
+	static auto firstPaint = true;
+	if (base::take(firstPaint)) {
+		Core::TraceInstant("Dialogs::InnerWidget::firstPaint");
+	}
+
 	Painter p(this);
 
 	p.setInactive(
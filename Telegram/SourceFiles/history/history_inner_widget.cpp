@@ -10,6 +10,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/file_utilities.h"
 #include "core/crash_reports.h"
 #include "core/click_handler_types.h"
+#include "core/core_trace.h"
 #include "history/history.h"
 #include "history/history_message.h"
 #include "history/view/media/history_view_media.h"
@@ -898,6 +899,7 @@ void HistoryInner::paintEvent(QPaintEvent *e) {
 	if (Ui::skipPaintEvent(this, e)) {
 		return;
 	}
+	TRACE_ZONE("HistoryInner::paintEvent");
 	if (hasPendingResizedItems()) {
 		return;
 	} else if (_recountedAfterPendingResizedItems) {
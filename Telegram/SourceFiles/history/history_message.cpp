@@ -34,6 +34,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_web_page.h"
 #include "data/data_sponsored_messages.h"
 #include "data/data_scheduled_messages.h"
+#include "data/data_messages_index.h"
 #include "styles/style_dialogs.h"
 #include "styles/style_widgets.h"
 #include "styles/style_chat.h"
@@ -1506,6 +1507,7 @@ void HistoryMessage::setText(const TextWithEntities &textWithEntities) {
 void HistoryMessage::setTextValue(TextWithEntities text) {
 	const auto had = !_text.empty();
 	_text = std::move(text);
+	history()->owner().messagesIndex().refresh(this);
 	if (had) {
 		history()->owner().requestItemTextRefresh(this);
 	}
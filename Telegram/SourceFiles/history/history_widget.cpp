@@ -71,6 +71,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_sponsored_messages.h"
 #include "data/data_file_origin.h"
 #include "data/data_histories.h"
+#include "data/data_histories_memory.h"
 #include "data/data_group_call.h"
 #include "data/stickers/data_stickers.h"
 #include "data/stickers/data_custom_emoji.h"
@@ -123,6 +124,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "media/audio/media_audio_capture.h"
 #include "media/player/media_player_instance.h"
 #include "core/application.h"
+#include "core/core_trace.h"
 #include "apiwrap.h"
 #include "base/options.h"
 #include "base/qthelp_regex.h"
@@ -2029,6 +2031,8 @@ void HistoryWidget::showHistory(
 		const PeerId &peerId,
 		MsgId showAtMsgId,
 		bool reload) {
+	TRACE_ZONE("HistoryWidget::showHistory");
+
 	_pinnedClickedId = FullMsgId();
 	_minPinnedId = std::nullopt;
 
@@ -2382,6 +2386,11 @@ void HistoryWidget::setHistory(History *history) {
 			history->forceFullResize();
 		}
 	};
+	const auto touchHistoryMemory = [](History *history) {
+		if (history) {
+			history->owner().histories().memory().touch(history);
+		}
+	};
 
 	if (_history) {
 		unregisterDraftSources();
@@ -2391,10 +2400,14 @@ void HistoryWidget::setHistory(History *history) {
 		const auto wasMigrated = base::take(_migrated);
 		unloadHeavyViewParts(wasHistory);
 		unloadHeavyViewParts(wasMigrated);
+		touchHistoryMemory(wasHistory);
+		touchHistoryMemory(wasMigrated);
 	}
 	if (history) {
 		_history = history;
 		_migrated = _history ? _history->migrateFrom() : nullptr;
+		touchHistoryMemory(_history);
+		touchHistoryMemory(_migrated);
 		registerDraftSource();
 	}
 	refreshAttachBotsMenu();
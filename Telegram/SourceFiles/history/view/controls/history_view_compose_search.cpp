@@ -9,6 +9,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "api/api_messages_search_merged.h"
 #include "boxes/peer_list_box.h"
+#include "data/data_messages_index.h"
 #include "data/data_session.h"
 #include "dialogs/dialogs_search_from_controllers.h" // SearchFromBox
 #include "dialogs/ui/dialogs_layout.h"
@@ -661,6 +662,7 @@ public:
 private:
 	void showAnimated();
 	void hideList();
+	void showLocalFound(const SearchRequest &search);
 
 	const not_null<Window::SessionController*> _window;
 	const not_null<History*> _history;
@@ -669,6 +671,7 @@ private:
 	const List _list;
 
 	Api::MessagesSearchMerged _apiSearch;
+	bool _serverFound = false;
 
 	struct {
 		struct {
@@ -715,6 +718,10 @@ ComposeSearch::Inner::Inner(
 		if (search.query.isEmpty() && !search.from) {
 			return;
 		}
+		// Cached server results may arrive right inside search(),
+		// so the local ones are shown first and replaced by them.
+		_serverFound = false;
+		showLocalFound(search);
 		_apiSearch.clear();
 		_apiSearch.search(search);
 	}, _topBar->lifetime());
@@ -741,6 +748,7 @@ ComposeSearch::Inner::Inner(
 	_apiSearch.newFounds(
 	) | rpl::start_with_next([=] {
 		const auto &apiData = _apiSearch.messages();
+		_serverFound = true;
 		_bottomBar->setTotal(apiData.total);
 		_list.controller->addItems(apiData.messages, true);
 	}, _topBar->lifetime());
@@ -856,6 +864,26 @@ void ComposeSearch::Inner::hideAnimated() {
 	_destroyRequests.fire({});
 }
 
+void ComposeSearch::Inner::showLocalFound(const SearchRequest &search) {
+	if (search.query.isEmpty() || _serverFound) {
+		return;
+	}
+	// Show what we already have in memory while the server is searching.
+	// The list is replaced as soon as the first server results arrive.
+	const auto &index = _history->owner().messagesIndex();
+	auto found = index.search(_history->peer, search.query, search.from);
+	if (const auto migrated = _history->migrateFrom()) {
+		const auto more = index.search(
+			migrated->peer,
+			search.query,
+			search.from);
+		found.insert(end(found), begin(more), end(more));
+	}
+	if (!found.empty()) {
+		_list.controller->addItems(found, true);
+	}
+}
+
 void ComposeSearch::Inner::hideList() {
 	if (!_list.container->isHidden()) {
 		Ui::Animations::HideWidgets({ _list.container.get() });
@@ -471,13 +471,25 @@ void Sticker::setupPlayer() {
 	Expects(_dataMedia != nullptr);
 
 	if (_data->sticker()->isLottie()) {
-		_player = std::make_unique<LottiePlayer>(
-			ChatHelpers::LottiePlayerFromDocument(
+		const auto box = countOptimalSize() * style::DevicePixelRatio();
+		auto create = [&] {
+			return ChatHelpers::LottiePlayerFromDocument(
 				_dataMedia.get(),
 				_replacements,
 				_cachingTag,
-				countOptimalSize() * style::DevicePixelRatio(),
-				Lottie::Quality::High));
+				box,
+				Lottie::Quality::High);
+		};
+		if (canSharePlayer()) {
+			const auto key = SharedLottiePlayer::Key{
+				.document = _data,
+				.width = box.width(),
+				.height = box.height(),
+			};
+			_player = SharedLottiePlayer::Make(key, create);
+		} else {
+			_player = std::make_unique<LottiePlayer>(create());
+		}
 	} else if (_data->sticker()->isWebm()) {
 		_player = std::make_unique<WebmPlayer>(
 			_dataMedia->owner()->location(),
@@ -489,6 +501,15 @@ void Sticker::setupPlayer() {
 	playerCreated();
 }
 
+bool Sticker::canSharePlayer() const {
+	// Players of stickers played once keep per view state.
+	return !_replacements
+		&& (_diceIndex < 0)
+		&& !customEmojiPart()
+		&& !isEmojiSticker()
+		&& Core::App().settings().loopAnimatedStickers();
+}
+
 void Sticker::checkPremiumEffectStart() {
 	if (!_premiumEffectPlayed && hasPremiumEffect()) {
 		_premiumEffectPlayed = true;
@@ -7,13 +7,37 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "history/view/media/history_view_sticker_player.h"
 
+#include "ui/image/image_prepare.h"
+
 namespace HistoryView {
 namespace {
 
 using ClipNotification = ::Media::Clip::Notification;
 
+// Lottie renderer keeps this many prepared frames per player.
+constexpr auto kLottieFramesBuffered = 4;
+
 } // namespace
 
+struct SharedLottiePlayer::Shared {
+	~Shared();
+
+	Key key;
+	std::unique_ptr<Lottie::SinglePlayer> lottie;
+	base::flat_map<not_null<SharedLottiePlayer*>, Fn<void()>> repaints;
+	int shownIndex = -1;
+	rpl::lifetime lifetime;
+};
+
+auto SharedLottiePlayer::Registry()
+-> base::flat_map<Key, std::weak_ptr<Shared>> & {
+	// Never freed, players may outlive static destruction on quit.
+	static const auto result = new base::flat_map<
+		Key,
+		std::weak_ptr<Shared>>();
+	return *result;
+}
+
 LottiePlayer::LottiePlayer(std::unique_ptr<Lottie::SinglePlayer> lottie)
 : _lottie(std::move(lottie)) {
 }
@@ -56,6 +80,119 @@ bool LottiePlayer::markFrameShown() {
 	return _lottie->markFrameShown();
 }
 
+SharedLottiePlayer::Shared::~Shared() {
+	auto &registry = Registry();
+	const auto i = registry.find(key);
+	if (i != end(registry) && i->second.expired()) {
+		registry.erase(i);
+	}
+}
+
+std::unique_ptr<SharedLottiePlayer> SharedLottiePlayer::Make(
+		Key key,
+		FnMut<std::unique_ptr<Lottie::SinglePlayer>()> create) {
+	auto &registry = Registry();
+	auto shared = std::shared_ptr<Shared>();
+	if (const auto i = registry.find(key); i != end(registry)) {
+		shared = i->second.lock();
+	}
+	if (!shared) {
+		shared = std::make_shared<Shared>();
+		shared->key = key;
+		shared->lottie = create();
+
+		const auto raw = shared.get();
+		raw->lottie->updates(
+		) | rpl::start_with_next([=] {
+			auto callbacks = std::vector<Fn<void()>>();
+			callbacks.reserve(raw->repaints.size());
+			for (const auto &[player, callback] : raw->repaints) {
+				callbacks.push_back(callback);
+			}
+			for (const auto &callback : callbacks) {
+				callback();
+			}
+		}, raw->lifetime);
+		registry[key] = shared;
+
+		const auto stats = Stats();
+		DEBUG_LOG(("Stickers: %1 shared players for %2 views, ~%3 bytes."
+			).arg(stats.players
+			).arg(stats.views
+			).arg(stats.memory));
+	}
+	return std::unique_ptr<SharedLottiePlayer>(
+		new SharedLottiePlayer(std::move(shared)));
+}
+
+SharedStickerPlayersStats SharedLottiePlayer::Stats() {
+	auto result = SharedStickerPlayersStats();
+	for (const auto &[key, weak] : Registry()) {
+		if (const auto shared = weak.lock()) {
+			++result.players;
+			result.views += int(shared->repaints.size());
+			result.memory += int64(key.width)
+				* key.height
+				* 4
+				* kLottieFramesBuffered;
+		}
+	}
+	return result;
+}
+
+SharedLottiePlayer::SharedLottiePlayer(std::shared_ptr<Shared> shared)
+: _shared(std::move(shared)) {
+}
+
+SharedLottiePlayer::~SharedLottiePlayer() {
+	_shared->repaints.remove(this);
+}
+
+void SharedLottiePlayer::setRepaintCallback(Fn<void()> callback) {
+	_shared->repaints[this] = std::move(callback);
+}
+
+bool SharedLottiePlayer::ready() {
+	return _shared->lottie->ready();
+}
+
+int SharedLottiePlayer::framesCount() {
+	return _shared->lottie->information().framesCount;
+}
+
+SharedLottiePlayer::FrameInfo SharedLottiePlayer::frame(
+		QSize size,
+		QColor colored,
+		bool mirrorHorizontal,
+		crl::time now,
+		bool paused) {
+	// Every view asks for the same request, so the renderer never
+	// switches between variants. Per-view effects are applied on top.
+	auto request = Lottie::FrameRequest();
+	request.box = size * style::DevicePixelRatio();
+	const auto info = _shared->lottie->frameInfo(request);
+	_frameIndex = info.index;
+
+	auto image = info.image;
+	if (mirrorHorizontal) {
+		image = image.mirrored(true, false);
+	}
+	if (colored.alpha() != 0) {
+		image = Images::Colored(std::move(image), colored);
+	}
+	return { .image = std::move(image), .index = info.index };
+}
+
+bool SharedLottiePlayer::markFrameShown() {
+	if (_shared->shownIndex == _frameIndex) {
+		return false;
+	} else if (!_shared->lottie->markFrameShown()) {
+		return false;
+	}
+	_shared->shownIndex = _frameIndex;
+	return true;
+}
+
 WebmPlayer::WebmPlayer(
 	const Core::FileLocation &location,
 	const QByteArray &data,
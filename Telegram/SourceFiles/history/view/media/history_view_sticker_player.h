@@ -12,6 +12,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "lottie/lottie_single_player.h"
 #include "media/clip/media_clip_reader.h"
 
+class DocumentData;
+
 namespace Core {
 class FileLocation;
 } // namespace Core
@@ -39,6 +41,56 @@ private:
 
 };
 
+struct SharedStickerPlayersStats {
+	int players = 0;
+	int views = 0;
+	int64 memory = 0;
+};
+
+// One Lottie::SinglePlayer rendering a document at one size, shared by
+// every looping history sticker showing it. The first view painting a
+// frame marks it shown, the rest draw the same image.
+class SharedLottiePlayer final : public StickerPlayer {
+public:
+	struct Key {
+		not_null<DocumentData*> document;
+		int width = 0;
+		int height = 0;
+
+		friend inline auto operator<=>(Key, Key) = default;
+	};
+
+	[[nodiscard]] static std::unique_ptr<SharedLottiePlayer> Make(
+		Key key,
+		FnMut<std::unique_ptr<Lottie::SinglePlayer>()> create);
+	[[nodiscard]] static SharedStickerPlayersStats Stats();
+
+	~SharedLottiePlayer();
+
+	void setRepaintCallback(Fn<void()> callback) override;
+	bool ready() override;
+	int framesCount() override;
+	FrameInfo frame(
+		QSize size,
+		QColor colored,
+		bool mirrorHorizontal,
+		crl::time now,
+		bool paused) override;
+	bool markFrameShown() override;
+
+private:
+	struct Shared;
+
+	explicit SharedLottiePlayer(std::shared_ptr<Shared> shared);
+
+	[[nodiscard]] static auto Registry()
+		-> base::flat_map<Key, std::weak_ptr<Shared>> &;
+
+	const std::shared_ptr<Shared> _shared;
+	int _frameIndex = -1;
+
+};
+
 class WebmPlayer final : public StickerPlayer {
 public:
 	WebmPlayer(
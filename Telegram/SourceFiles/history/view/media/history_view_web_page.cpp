@@ -466,6 +466,8 @@ void WebPage::unloadHeavyPart() {
 		_attach->unloadHeavyPart();
 	}
 	_description.unloadPersistentAnimation();
+	_pixRequest.cancel();
+	_pixLast = QPixmap();
 	_photoMedia = nullptr;
 }
 
@@ -520,12 +522,24 @@ void WebPage::draw(Painter &p, const PaintContext &context) const {
 			.options = Images::Option::RoundSmall,
 			.outer = { pw, ph },
 		};
+		const auto ready = [=] { repaint(); };
 		if (const auto thumbnail = _photoMedia->image(
 				Data::PhotoSize::Thumbnail)) {
-			pix = thumbnail->pixSingle(size, args);
+			pix = thumbnail->pixSingleAsync(size, args, _pixRequest, ready);
 		} else if (const auto small = _photoMedia->image(
 				Data::PhotoSize::Small)) {
-			pix = small->pixSingle(size, args.blurred());
+			pix = small->pixSingleAsync(
+				size,
+				args.blurred(),
+				_pixRequest,
+				ready);
+		}
+		const auto outer = QSize(pw, ph) * style::DevicePixelRatio();
+		if (!pix.isNull()) {
+			_pixLast = pix;
+		} else if (_pixLast.size() == outer) {
+			// Keep showing the previous variant until the new one is ready.
+			pix = _pixLast;
 		} else if (const auto blurred = _photoMedia->thumbnailInline()) {
 			pix = blurred->pixSingle(size, args.blurred());
 		}
@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "history/view/media/history_view_media.h"
+#include "ui/image/image.h"
 
 namespace Data {
 class Media;
@@ -115,6 +116,8 @@ private:
 	ClickHandlerPtr _openl;
 	std::unique_ptr<Media> _attach;
 	mutable std::shared_ptr<Data::PhotoMedia> _photoMedia;
+	mutable Images::PrepareRequest _pixRequest;
+	mutable QPixmap _pixLast;
 
 	bool _asArticle = false;
 	bool _hasViewButton = false;
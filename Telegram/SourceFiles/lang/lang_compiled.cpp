@@ -0,0 +1,187 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "lang/lang_compiled.h"
+
+#include "lang_auto.h"
+
+#include <QtCore/QSaveFile>
+
+namespace Lang {
+namespace {
+
+constexpr auto kMagic = std::array<char, 4>{ { 'T', 'D', 'L', 'C' } };
+constexpr auto kFormatVersion = int32(1);
+constexpr auto kChecksumSize = 16;
+constexpr auto kDefaultValue = uint32(0xFFFFFFFFU);
+
+// magic + formatVersion + keysCount + checksum
+constexpr auto kHeaderSize = int(kMagic.size())
+	+ 2 * int(sizeof(int32))
+	+ kChecksumSize;
+
+// offset + size, both in QChar-s
+constexpr auto kEntrySize = 2 * int(sizeof(uint32));
+
+[[nodiscard]] int TableSize() {
+	return kKeysCount * kEntrySize;
+}
+
+[[nodiscard]] int FlagsSize() {
+	// Keep the pool aligned by QChar.
+	return kKeysCount + (kKeysCount % 2);
+}
+
+[[nodiscard]] int PoolOffset() {
+	return kHeaderSize + TableSize() + FlagsSize();
+}
+
+[[nodiscard]] uint32 ReadUInt(const uchar *from) {
+	auto result = uint32();
+	memcpy(&result, from, sizeof(result));
+	return result;
+}
+
+template <typename Value>
+void Append(QByteArray &to, Value value) {
+	to.append(reinterpret_cast<const char*>(&value), sizeof(Value));
+}
+
+} // namespace
+
+CompiledPack::CompiledPack(std::unique_ptr<QFile> file, const uchar *data)
+: _file(std::move(file))
+, _table(data + kHeaderSize)
+, _flags(_table + TableSize())
+, _pool(reinterpret_cast<const QChar*>(data + PoolOffset())) {
+}
+
+CompiledPack::~CompiledPack() = default;
+
+QByteArray CompiledPack::Checksum(const QByteArray &serialized) {
+	auto data = serialized;
+	Append(data, int32(AppVersion));
+	Append(data, int32(kKeysCount));
+	const auto result = hashMd5(data.constData(), data.size());
+	return QByteArray(result.data(), result.size());
+}
+
+std::unique_ptr<CompiledPack> CompiledPack::Open(
+		const QString &path,
+		const QByteArray &checksum) {
+	Expects(checksum.size() == kChecksumSize);
+
+	auto file = std::make_unique<QFile>(path);
+	if (!file->open(QIODevice::ReadOnly)) {
+		return nullptr;
+	}
+	const auto size = file->size();
+	if (size < PoolOffset() || size > std::numeric_limits<int32>::max()) {
+		return nullptr;
+	}
+	const auto data = file->map(0, size);
+	if (!data) {
+		return nullptr;
+	}
+	auto header = data;
+	const auto readInt = [&] {
+		const auto result = int32(ReadUInt(header));
+		header += sizeof(int32);
+		return result;
+	};
+	if (memcmp(header, kMagic.data(), kMagic.size()) != 0) {
+		return nullptr;
+	}
+	header += kMagic.size();
+	if (readInt() != kFormatVersion
+		|| readInt() != kKeysCount
+		|| memcmp(header, checksum.constData(), kChecksumSize) != 0) {
+		return nullptr;
+	}
+
+	// Check the whole table once, so that value() can trust it.
+	const auto poolSize = uint64(size - PoolOffset()) / sizeof(QChar);
+	for (auto i = 0; i != kKeysCount; ++i) {
+		const auto entry = data + kHeaderSize + i * kEntrySize;
+		const auto offset = ReadUInt(entry);
+		const auto length = ReadUInt(entry + sizeof(uint32));
+		if (offset != kDefaultValue
+			&& uint64(offset) + length > poolSize) {
+			LOG(("Lang Error: Bad compiled pack entry %1.").arg(i));
+			return nullptr;
+		}
+	}
+	return std::unique_ptr<CompiledPack>(
+		new CompiledPack(std::move(file), data));
+}
+
+bool CompiledPack::Write(
+		const QString &path,
+		const QByteArray &checksum,
+		const std::vector<QString> &values,
+		const std::vector<uchar> &flags) {
+	Expects(checksum.size() == kChecksumSize);
+	Expects(values.size() == kKeysCount);
+	Expects(flags.size() == kKeysCount);
+
+	auto table = QByteArray();
+	auto pool = QByteArray();
+	table.reserve(TableSize());
+	for (auto i = 0; i != kKeysCount; ++i) {
+		const auto &value = values[i];
+		if (value == GetOriginalValue(ushort(i))) {
+			Append(table, kDefaultValue);
+			Append(table, uint32(0));
+			continue;
+		}
+		Append(table, uint32(pool.size() / sizeof(QChar)));
+		Append(table, uint32(value.size()));
+		pool.append(
+			reinterpret_cast<const char*>(value.constData()),
+			value.size() * sizeof(QChar));
+	}
+
+	auto result = QByteArray();
+	result.reserve(PoolOffset() + pool.size());
+	result.append(kMagic.data(), kMagic.size());
+	Append(result, kFormatVersion);
+	Append(result, int32(kKeysCount));
+	result.append(checksum);
+	result.append(table);
+	result.append(reinterpret_cast<const char*>(flags.data()), kKeysCount);
+	result.append(QByteArray(FlagsSize() - kKeysCount, char(0)));
+	result.append(pool);
+
+	auto file = QSaveFile(path);
+	if (!file.open(QIODevice::WriteOnly)
+		|| file.write(result) != result.size()
+		|| !file.commit()) {
+		LOG(("Lang Error: Could not write compiled pack to '%1'."
+			).arg(path));
+		return false;
+	}
+	return true;
+}
+
+QString CompiledPack::value(ushort key) const {
+	Expects(key < kKeysCount);
+
+	const auto entry = _table + key * kEntrySize;
+	const auto offset = ReadUInt(entry);
+	if (offset == kDefaultValue) {
+		return GetOriginalValue(key);
+	}
+	return QString(_pool + offset, int(ReadUInt(entry + sizeof(uint32))));
+}
+
+uchar CompiledPack::flags(ushort key) const {
+	Expects(key < kKeysCount);
+
+	return _flags[key];
+}
+
+} // namespace Lang
@@ -0,0 +1,47 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+namespace Lang {
+
+inline constexpr auto kCompiledNonDefault = uchar(0x01);
+inline constexpr auto kCompiledBaseNonDefault = uchar(0x02);
+
+// Resolved values of the current language pack by key index: an offset
+// table and a UTF-16 string pool in one file, memory mapped on start
+// instead of parsing every value of the serialized pack again.
+class CompiledPack final {
+public:
+	~CompiledPack();
+
+	// Checksum of the serialized pack and of the keys of this build.
+	[[nodiscard]] static QByteArray Checksum(const QByteArray &serialized);
+
+	[[nodiscard]] static std::unique_ptr<CompiledPack> Open(
+		const QString &path,
+		const QByteArray &checksum);
+	static bool Write(
+		const QString &path,
+		const QByteArray &checksum,
+		const std::vector<QString> &values,
+		const std::vector<uchar> &flags);
+
+	[[nodiscard]] QString value(ushort key) const;
+	[[nodiscard]] uchar flags(ushort key) const;
+
+private:
+	CompiledPack(std::unique_ptr<QFile> file, const uchar *data);
+
+	const std::unique_ptr<QFile> _file;
+	const uchar *_table = nullptr;
+	const uchar *_flags = nullptr;
+	const QChar *_pool = nullptr;
+
+};
+
+} // namespace Lang
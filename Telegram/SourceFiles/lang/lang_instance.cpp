@@ -8,9 +8,11 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "lang/lang_instance.h"
 
 #include "core/application.h"
+#include "core/core_trace.h"
 #include "storage/serialize_common.h"
 #include "storage/localstorage.h"
 #include "ui/boxes/confirm_box.h"
+#include "lang/lang_compiled.h"
 #include "lang/lang_file_parser.h"
 #include "lang/lang_tag.h" // kTextCommandLangTag.
 #include "base/platform/base_platform_info.h"
@@ -252,6 +254,10 @@ Instance::Instance(not_null<Instance*> derived, const PrivateTag &)
 , _nonDefaultSet(kKeysCount, 0) {
 }
 
+Instance::Instance(Instance &&other) = default;
+Instance &Instance::operator=(Instance &&other) = default;
+Instance::~Instance() = default;
+
 void Instance::switchToId(const Language &data) {
 	reset(data);
 	if (_id == qstr("#TEST_X") || _id == qstr("#TEST_0")) {
@@ -284,6 +290,8 @@ void Instance::switchToCustomFile(const QString &filePath) {
 }
 
 void Instance::reset(const Language &data) {
+	dropCompiled();
+
 	const auto computedPluralId = !data.pluralId.isEmpty()
 		? data.pluralId
 		: !data.baseId.isEmpty()
@@ -428,6 +436,14 @@ QByteArray Instance::serialize() const {
 void Instance::fillFromSerialized(
 		const QByteArray &data,
 		int dataAppVersion) {
+	TRACE_ZONE("Lang::Instance::fillFromSerialized");
+	auto compiled = _derived
+		? nullptr
+		: CompiledPack::Open(
+			Local::langPackCompiledPath(),
+			CompiledPack::Checksum(data));
+	dropCompiled();
+
 	QDataStream stream(data);
 	stream.setVersion(QDataStream::Qt_5_1);
 	qint32 serializeVersion = 0;
@@ -506,6 +522,9 @@ void Instance::fillFromSerialized(
 		nonDefaultStrings.push_back(value);
 	}
 
+	if (compiled) {
+		setCompiled(std::move(compiled));
+	}
 	_base = nullptr;
 	QByteArray base;
 	if (legacyFormat) {
@@ -545,16 +564,95 @@ void Instance::fillFromSerialized(
 	_customFilePathAbsolute = customFilePathAbsolute;
 	_customFilePathRelative = customFilePathRelative;
 	_customFileContent = customFileContent;
-	LOG(("Lang Info: Loaded cached, keys: %1").arg(nonDefaultValuesCount));
+	const auto owner = _derived ? _derived : this;
+	LOG(("Lang Info: Loaded cached, keys: %1, compiled: %2"
+		).arg(nonDefaultValuesCount
+		).arg(Logs::b(owner->_compiled != nullptr)));
 	for (auto i = 0, count = nonDefaultValuesCount * 2; i != count; i += 2) {
-		applyValue(nonDefaultStrings[i], nonDefaultStrings[i + 1]);
+		if (owner->_compiled) {
+			// The parsed values and flags come from the compiled pack.
+			const auto &key = nonDefaultStrings[i];
+			_nonDefaultValues[key] = nonDefaultStrings[i + 1];
+		} else {
+			applyValue(nonDefaultStrings[i], nonDefaultStrings[i + 1]);
+		}
+	}
+	if (_compiled && _base) {
+		for (auto i = 0; i != kKeysCount; ++i) {
+			_base->_nonDefaultSet[i] = (_compiled->flags(ushort(i))
+				& kCompiledBaseNonDefault) ? 1 : 0;
+		}
 	}
 	updatePluralRules();
 	updateChoosingStickerReplacement();
 
+	if (!_derived && !_compiled) {
+		writeCompiled(data);
+	}
+
 	_idChanges.fire_copy(_id);
 }
 
+void Instance::writeCompiled(const QByteArray &serialized) const {
+	Expects(!_derived);
+
+	if (_compiled) {
+		// Nothing was changed since the pack was mapped.
+		return;
+	}
+	auto values = std::vector<QString>();
+	auto flags = std::vector<uchar>(kKeysCount, 0);
+	values.reserve(kKeysCount);
+	for (auto i = 0; i != kKeysCount; ++i) {
+		values.push_back(getValue(ushort(i)));
+		if (_nonDefaultSet[i]) {
+			flags[i] |= kCompiledNonDefault;
+		}
+		if (_base && _base->_nonDefaultSet[i]) {
+			flags[i] |= kCompiledBaseNonDefault;
+		}
+	}
+	crl::async([
+		path = Local::langPackCompiledPath(),
+		checksum = CompiledPack::Checksum(serialized),
+		values = std::move(values),
+		flags = std::move(flags)
+	] {
+		CompiledPack::Write(path, checksum, values, flags);
+	});
+}
+
+void Instance::setCompiled(std::unique_ptr<CompiledPack> compiled) {
+	Expects(!_derived);
+
+	_compiled = std::move(compiled);
+	_compiledRead.assign(kKeysCount, 0);
+	for (auto i = 0; i != kKeysCount; ++i) {
+		_nonDefaultSet[i] = (_compiled->flags(ushort(i))
+			& kCompiledNonDefault) ? 1 : 0;
+	}
+}
+
+void Instance::readCompiledValue(ushort key) const {
+	Expects(_compiled != nullptr);
+
+	_values[key] = _compiled->value(key);
+	_compiledRead[key] = 1;
+}
+
+void Instance::dropCompiled() {
+	if (!_compiled) {
+		return;
+	}
+	for (auto i = 0; i != kKeysCount; ++i) {
+		if (!_compiledRead[i]) {
+			readCompiledValue(ushort(i));
+		}
+	}
+	_compiled = nullptr;
+	_compiledRead.clear();
+}
+
 void Instance::loadFromContent(const QByteArray &content) {
 	Lang::FileParser loader(content, [this](QLatin1String key, const QByteArray &value) {
 		applyValue(QByteArray(key.data(), key.size()), value);
@@ -734,6 +832,7 @@ QString Instance::getNonDefaultValue(const QByteArray &key) const {
 }
 
 void Instance::applyValue(const QByteArray &key, const QByteArray &value) {
+	(_derived ? _derived : this)->dropCompiled();
 	_nonDefaultValues[key] = value;
 	ParseKeyValue(key, value, [&](ushort key, QString &&value) {
 		_nonDefaultSet[key] = 1;
@@ -765,6 +864,7 @@ void Instance::updatePluralRules() {
 }
 
 void Instance::resetValue(const QByteArray &key) {
+	(_derived ? _derived : this)->dropCompiled();
 	_nonDefaultValues.erase(key);
 
 	const auto keyIndex = GetKeyIndex(QLatin1String(key));
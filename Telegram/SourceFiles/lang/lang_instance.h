@@ -13,6 +13,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 namespace Lang {
 
+class CompiledPack;
+
 inline constexpr auto kChoosingStickerReplacement = "oo"_cs;
 
 struct Language {
@@ -52,14 +54,15 @@ class Instance {
 public:
 	Instance();
 	Instance(not_null<Instance*> derived, const PrivateTag &);
+	~Instance();
 
 	void switchToId(const Language &language);
 	void switchToCustomFile(const QString &filePath);
 
 	Instance(const Instance &other) = delete;
 	Instance &operator=(const Instance &other) = delete;
-	Instance(Instance &&other) = default;
-	Instance &operator=(Instance &&other) = default;
+	Instance(Instance &&other);
+	Instance &operator=(Instance &&other);
 
 	QString systemLangCode() const;
 	QString langPackName() const;
@@ -76,6 +79,10 @@ public:
 	QByteArray serialize() const;
 	void fillFromSerialized(const QByteArray &data, int dataAppVersion);
 
+	// Writes the values resolved from the serialized pack to a file,
+	// that is mapped by fillFromSerialized() instead of parsing it.
+	void writeCompiled(const QByteArray &serialized) const;
+
 	bool supportChoosingStickerReplacement() const;
 	int rightIndexChoosingStickerReplacement(bool named) const;
 
@@ -92,6 +99,9 @@ public:
 	QString getValue(ushort key) const {
 		Expects(key < _values.size());
 
+		if (_compiled && !_compiledRead[key]) {
+			readCompiledValue(key);
+		}
 		return _values[key];
 	}
 	QString getNonDefaultValue(const QByteArray &key) const;
@@ -126,6 +136,9 @@ private:
 		const QByteArray &content);
 	void updatePluralRules();
 	void updateChoosingStickerReplacement();
+	void setCompiled(std::unique_ptr<CompiledPack> compiled);
+	void readCompiledValue(ushort key) const;
+	void dropCompiled();
 
 	Instance *_derived = nullptr;
 
@@ -146,10 +159,14 @@ private:
 
 	mutable QString _systemLanguage;
 
-	std::vector<QString> _values;
+	mutable std::vector<QString> _values;
 	std::vector<uchar> _nonDefaultSet;
 	std::map<QByteArray, QByteArray> _nonDefaultValues;
 
+	// While set, values not read yet are taken from the mapped file.
+	std::unique_ptr<CompiledPack> _compiled;
+	mutable std::vector<uchar> _compiledRead;
+
 	std::unique_ptr<Instance> _base;
 
 };
@@ -11,11 +11,29 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/crash_reports.h"
 #include "core/launcher.h"
 #include "mtproto/facade.h"
+#include "mtproto/details/mtproto_binary_dump.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else // Q_OS_WIN
+#include <unistd.h>
+#endif // Q_OS_WIN
 
 namespace {
 
+constexpr auto kRingSize = 256 * 1024;
+constexpr auto kRingEntryMaxSize = kRingSize / 4;
+constexpr auto kWriterIdleTimeout = std::chrono::milliseconds(20);
+constexpr auto kMaxCrashRings = 64;
+constexpr auto kCrashChunkSize = 1024;
+
 std::atomic<int> ThreadCounter/* = 0*/;
 thread_local bool WritingEntryFlag/* = false*/;
+thread_local bool WriterThreadFlag/* = false*/;
 
 class WritingEntryScope final {
 public:
@@ -34,6 +52,7 @@ enum LogDataType {
 	LogDataDebug,
 	LogDataTcp,
 	LogDataMtp,
+	LogDataMtpBinary,
 
 	LogDataCount
 };
@@ -56,6 +75,7 @@ QString _logsFilePath(LogDataType type, const QString &postfix = QString()) {
 	case LogDataDebug: path += qstr("DebugLogs/log") + postfix + qstr(".txt"); break;
 	case LogDataTcp: path += qstr("DebugLogs/tcp") + postfix + qstr(".txt"); break;
 	case LogDataMtp: path += qstr("DebugLogs/mtp") + postfix + qstr(".txt"); break;
+	case LogDataMtpBinary: path += qstr("DebugLogs/mtp") + postfix + qstr(".tlb"); break;
 	}
 	return path;
 }
@@ -76,9 +96,15 @@ public:
 	LogsDataFields() {
 		for (int32 i = 0; i < LogDataCount; ++i) {
 			files[i].reset(new QFile());
+			descriptors[i] = -1;
 		}
 	}
 
+	// Plain descriptor of the open file, for writing from a crash handler.
+	[[nodiscard]] int crashDescriptor(LogDataType type) const {
+		return descriptors[type].load(std::memory_order_acquire);
+	}
+
 	bool openMain() {
 		return reopen(LogDataMain, 0, qsl("start"));
 	}
@@ -89,6 +115,7 @@ public:
 
 		const auto file = files[LogDataMain].get();
 		if (file && file->isOpen()) {
+			descriptors[LogDataMain] = -1;
 			file->close();
 		}
 	}
@@ -111,6 +138,10 @@ public:
 	}
 
 	void write(LogDataType type, const QString &msg) {
+		write(type, msg.toUtf8());
+	}
+
+	void write(LogDataType type, const QByteArray &utf8) {
 		QMutexLocker lock(_logsMutex(type));
 		WritingEntryScope scope;
 
@@ -121,12 +152,18 @@ public:
 		if (!file || !file->isOpen()) {
 			return;
 		}
-		file->write(msg.toUtf8());
+		file->write(utf8);
 		file->flush();
 	}
 
 private:
+	void updateDescriptor(LogDataType type) {
+		const auto file = files[type].get();
+		descriptors[type] = (file && file->isOpen()) ? file->handle() : -1;
+	}
+
 	std::unique_ptr<QFile> files[LogDataCount];
+	std::atomic<int> descriptors[LogDataCount];
 
 	int32 part = -1;
 
@@ -137,6 +174,7 @@ private:
 					return true;
 				}
 			} else {
+				descriptors[type] = -1;
 				files[type]->close();
 			}
 		}
@@ -157,6 +195,7 @@ private:
 				}
 				if (to->open(mode | QIODevice::Append)) {
 					std::swap(files[type], to);
+					updateDescriptor(type);
 					LOG(("Moved logging from '%1' to '%2'!").arg(to->fileName(), files[type]->fileName()));
 					to->remove();
 
@@ -199,6 +238,21 @@ private:
 					LogsStartIndexChosen = oldest;
 				}
 			}
+		} else if (type == LogDataMtpBinary) {
+			mode = QIODevice::WriteOnly;
+			files[type]->setFileName(_logsFilePath(type, postfix));
+			if (files[type]->exists()) {
+				if (files[type]->open(QIODevice::ReadOnly)) {
+					const auto header = files[type]->read(
+						MTP::details::BinaryDumpHeaderSize());
+					if (MTP::details::BinaryDumpDayIndex(header) == dayIndex) {
+						mode |= QIODevice::Append;
+					}
+					files[type]->close();
+				}
+			} else {
+				QDir().mkdir(cWorkingDir() + qstr("DebugLogs"));
+			}
 		} else {
 			files[type]->setFileName(_logsFilePath(type, postfix));
 			if (files[type]->exists()) {
@@ -213,7 +267,14 @@ private:
 			}
 		}
 		if (files[type]->open(mode)) {
-			if (type != LogDataMain) {
+			updateDescriptor(type);
+			if (type == LogDataMtpBinary) {
+				if (!(mode & QIODevice::Append)) {
+					files[type]->write(
+						MTP::details::BinaryDumpHeader(dayIndex));
+					files[type]->flush();
+				}
+			} else if (type != LogDataMain) {
 				files[type]->write(((mode & QIODevice::Append)
 					? qsl("\
 ----------------------------------------------------------------\n\
@@ -247,12 +308,378 @@ NEW LOGGING INSTANCE STARTED!!!\n\
 		reopen(LogDataDebug, dayIndex, postfix);
 		reopen(LogDataTcp, dayIndex, postfix);
 		reopen(LogDataMtp, dayIndex, postfix);
+		if (Logs::MtpBinaryEnabled()) {
+			reopen(LogDataMtpBinary, dayIndex, postfix);
+		}
 	}
 
 };
 
 LogsDataFields *LogsData = 0;
 
+struct LogsRecordHeader {
+	uint64 sequence = 0;
+	uint32 size = 0;
+	uint32 type = 0;
+};
+
+struct LogsRecord {
+	uint64 sequence = 0;
+	LogDataType type = LogDataMain;
+	QByteArray bytes; // Raw UTF-16 for the text logs.
+};
+
+// Single producer, single consumer byte ring, one for each writing thread.
+struct LogsRing {
+	explicit LogsRing(const void *owner) : owner(owner), data(kRingSize) {
+	}
+
+	void write(uint64 position, const void *from, int size) {
+		const auto offset = int(position % kRingSize);
+		const auto first = std::min(size, kRingSize - offset);
+		memcpy(data.data() + offset, from, first);
+		if (first < size) {
+			const auto rest = static_cast<const char*>(from) + first;
+			memcpy(data.data(), rest, size - first);
+		}
+	}
+	void read(uint64 position, void *to, int size) const {
+		const auto offset = int(position % kRingSize);
+		const auto first = std::min(size, kRingSize - offset);
+		memcpy(to, data.data() + offset, first);
+		if (first < size) {
+			memcpy(static_cast<char*>(to) + first, data.data(), size - first);
+		}
+	}
+
+	const void *owner = nullptr;
+	int crashSlot = -1;
+	std::vector<char> data;
+	std::atomic<uint64> head = 0; // Advanced by the producer.
+	std::atomic<uint64> tail = 0; // Advanced by the writer.
+	std::atomic<bool> finished = false;
+};
+
+struct LogsRingHolder {
+	~LogsRingHolder() {
+		if (ring) {
+			ring->finished = true;
+		}
+	}
+
+	std::shared_ptr<LogsRing> ring;
+};
+thread_local LogsRingHolder ThreadRing;
+
+// Rings visible to the crash handler, which can't lock the rings list.
+std::atomic<LogsRing*> CrashRings[kMaxCrashRings];
+
+void CrashWrite(int descriptor, const char *data, int size) {
+	while (size > 0) {
+#ifdef Q_OS_WIN
+		const auto written = _write(descriptor, data, size);
+#else // Q_OS_WIN
+		const auto written = int(::write(descriptor, data, size));
+#endif // Q_OS_WIN
+		if (written <= 0) {
+			return;
+		}
+		data += written;
+		size -= written;
+	}
+}
+
+// Converts UTF-16 from the ring to UTF-8 in stack buffers.
+void CrashWriteText(
+		int descriptor,
+		const LogsRing &ring,
+		uint64 position,
+		int size) {
+	char16_t chunk[kCrashChunkSize];
+	char utf8[kCrashChunkSize * 3 + 4];
+	auto surrogate = uint32(0);
+	for (auto offset = 0; offset < size;) {
+		const auto bytes = std::min(size - offset, int(sizeof(chunk)));
+		ring.read(position + offset, chunk, bytes);
+		offset += bytes;
+
+		auto length = 0;
+		for (auto i = 0, count = bytes / 2; i != count; ++i) {
+			auto code = uint32(chunk[i]);
+			if (code >= 0xD800 && code < 0xDC00) {
+				surrogate = code;
+				continue;
+			} else if (code >= 0xDC00 && code < 0xE000) {
+				if (!surrogate) {
+					continue;
+				}
+				code = 0x10000
+					+ ((surrogate - 0xD800) << 10)
+					+ (code - 0xDC00);
+			}
+			surrogate = 0;
+			if (code < 0x80) {
+				utf8[length++] = char(code);
+			} else if (code < 0x800) {
+				utf8[length++] = char(0xC0 | (code >> 6));
+				utf8[length++] = char(0x80 | (code & 0x3F));
+			} else if (code < 0x10000) {
+				utf8[length++] = char(0xE0 | (code >> 12));
+				utf8[length++] = char(0x80 | ((code >> 6) & 0x3F));
+				utf8[length++] = char(0x80 | (code & 0x3F));
+			} else {
+				utf8[length++] = char(0xF0 | (code >> 18));
+				utf8[length++] = char(0x80 | ((code >> 12) & 0x3F));
+				utf8[length++] = char(0x80 | ((code >> 6) & 0x3F));
+				utf8[length++] = char(0x80 | (code & 0x3F));
+			}
+		}
+		CrashWrite(descriptor, utf8, length);
+	}
+}
+
+void CrashWriteBinary(
+		int descriptor,
+		const LogsRing &ring,
+		uint64 position,
+		int size) {
+	char chunk[kCrashChunkSize];
+	for (auto offset = 0; offset < size;) {
+		const auto bytes = std::min(size - offset, int(sizeof(chunk)));
+		ring.read(position + offset, chunk, bytes);
+		CrashWrite(descriptor, chunk, bytes);
+		offset += bytes;
+	}
+}
+
+// Entries are copied to the ring of the calling thread without locking,
+// the writer thread merges all rings by sequence number, converts them
+// to UTF-8 and writes each file once per batch.
+class LogsAsyncWriter final {
+public:
+	LogsAsyncWriter() : _thread([=] { run(); }) {
+	}
+
+	~LogsAsyncWriter() {
+		{
+			auto lock = std::unique_lock(_wakeMutex);
+			_stopping = true;
+		}
+		_wake.notify_one();
+		_thread.join();
+		flush();
+		for (const auto &ring : _rings) {
+			if (ring->crashSlot >= 0) {
+				CrashRings[ring->crashSlot] = nullptr;
+			}
+		}
+	}
+
+	// Returns false if the entry should be written synchronously.
+	[[nodiscard]] bool push(LogDataType type, const QString &msg) {
+		return push(type, msg.constData(), int(msg.size() * sizeof(QChar)));
+	}
+
+	[[nodiscard]] bool push(LogDataType type, const void *data, int size) {
+		const auto full = int(sizeof(LogsRecordHeader)) + size;
+		if (full > kRingEntryMaxSize) {
+			return false;
+		}
+		const auto ring = currentRing();
+		const auto head = ring->head.load(std::memory_order_relaxed);
+		while (head + full - ring->tail.load(std::memory_order_acquire)
+			> kRingSize) {
+			if (WriterThreadFlag) {
+				// The writer can't wait for itself, drop the entry.
+				return true;
+			}
+			_wake.notify_one();
+			std::this_thread::yield();
+		}
+		const auto header = LogsRecordHeader{
+			.sequence = ++_sequence,
+			.size = uint32(size),
+			.type = uint32(type),
+		};
+		ring->write(head, &header, sizeof(header));
+		ring->write(head + sizeof(header), data, size);
+		ring->head.store(head + full, std::memory_order_release);
+		return true;
+	}
+
+	void flush() {
+		if (WriterThreadFlag) {
+			return;
+		}
+		auto lock = std::unique_lock(_drainMutex);
+		drain();
+	}
+
+	// Runs inside the signal handler: no locks and no allocations, the
+	// rings are merged by sequence on the stack and written with write()
+	// to the descriptors that are already open.
+	void flushOnCrash() {
+		struct Cursor {
+			const LogsRing *ring = nullptr;
+			uint64 tail = 0;
+			uint64 head = 0;
+			LogsRecordHeader header;
+		};
+		Cursor cursors[kMaxCrashRings];
+		auto count = 0;
+		const auto readHeader = [](Cursor &cursor) {
+			if (cursor.tail != cursor.head) {
+				cursor.ring->read(
+					cursor.tail,
+					&cursor.header,
+					sizeof(cursor.header));
+			}
+		};
+		for (auto &slot : CrashRings) {
+			if (const auto ring = slot.load(std::memory_order_acquire)) {
+				auto &cursor = cursors[count++];
+				cursor.ring = ring;
+				cursor.tail = ring->tail.load(std::memory_order_acquire);
+				cursor.head = ring->head.load(std::memory_order_acquire);
+				readHeader(cursor);
+			}
+		}
+		while (true) {
+			auto next = (Cursor*)nullptr;
+			for (auto i = 0; i != count; ++i) {
+				auto &cursor = cursors[i];
+				if (cursor.tail != cursor.head
+					&& (!next
+						|| cursor.header.sequence < next->header.sequence)) {
+					next = &cursor;
+				}
+			}
+			if (!next) {
+				break;
+			}
+			const auto &header = next->header;
+			const auto type = LogDataType(header.type);
+			const auto position = next->tail + sizeof(header);
+			const auto size = int(header.size);
+			const auto descriptor = (LogsData && header.type < LogDataCount)
+				? LogsData->crashDescriptor(type)
+				: -1;
+			if (descriptor >= 0) {
+				if (type == LogDataMtpBinary) {
+					CrashWriteBinary(descriptor, *next->ring, position, size);
+				} else {
+					CrashWriteText(descriptor, *next->ring, position, size);
+				}
+			}
+			next->tail = position + size;
+			readHeader(*next);
+		}
+	}
+
+private:
+	[[nodiscard]] not_null<LogsRing*> currentRing() {
+		auto &ring = ThreadRing.ring;
+		if (!ring || ring->owner != this) {
+			ring = std::make_shared<LogsRing>(this);
+			for (auto i = 0; i != kMaxCrashRings; ++i) {
+				auto expected = (LogsRing*)nullptr;
+				if (CrashRings[i].compare_exchange_strong(
+						expected,
+						ring.get())) {
+					ring->crashSlot = i;
+					break;
+				}
+			}
+			auto lock = std::unique_lock(_ringsMutex);
+			_rings.push_back(ring);
+		}
+		return ring.get();
+	}
+
+	void run() {
+		WriterThreadFlag = true;
+		while (true) {
+			const auto written = [&] {
+				auto lock = std::unique_lock(_drainMutex);
+				return drain();
+			}();
+			auto lock = std::unique_lock(_wakeMutex);
+			if (_stopping) {
+				break;
+			} else if (!written) {
+				_wake.wait_for(lock, kWriterIdleTimeout);
+			}
+		}
+	}
+
+	// Requires _drainMutex to be locked, returns false if nothing was read.
+	bool drain() {
+		const auto rings = [&] {
+			auto lock = std::unique_lock(_ringsMutex);
+			_rings.erase(ranges::remove_if(_rings, [](const auto &ring) {
+				const auto remove = ring->finished
+					&& (ring->head.load() == ring->tail.load());
+				if (remove && ring->crashSlot >= 0) {
+					CrashRings[ring->crashSlot] = nullptr;
+				}
+				return remove;
+			}), end(_rings));
+			return _rings;
+		}();
+		auto records = std::vector<LogsRecord>();
+		for (const auto &ring : rings) {
+			const auto head = ring->head.load(std::memory_order_acquire);
+			auto tail = ring->tail.load(std::memory_order_relaxed);
+			while (tail != head) {
+				auto header = LogsRecordHeader();
+				ring->read(tail, &header, sizeof(header));
+				auto bytes = QByteArray(header.size, Qt::Uninitialized);
+				ring->read(tail + sizeof(header), bytes.data(), header.size);
+				records.push_back({
+					.sequence = header.sequence,
+					.type = LogDataType(header.type),
+					.bytes = std::move(bytes),
+				});
+				tail += sizeof(header) + header.size;
+			}
+			ring->tail.store(tail, std::memory_order_release);
+		}
+		if (records.empty()) {
+			return false;
+		}
+		ranges::sort(records, ranges::less(), &LogsRecord::sequence);
+
+		QByteArray batches[LogDataCount];
+		for (const auto &record : records) {
+			if (record.type == LogDataMtpBinary) {
+				batches[record.type].append(record.bytes);
+			} else {
+				batches[record.type].append(QString(
+					reinterpret_cast<const QChar*>(record.bytes.constData()),
+					record.bytes.size() / sizeof(QChar)).toUtf8());
+			}
+		}
+		for (auto type = 0; type != LogDataCount; ++type) {
+			if (LogsData && !batches[type].isEmpty()) {
+				LogsData->write(LogDataType(type), batches[type]);
+			}
+		}
+		return true;
+	}
+
+	std::vector<std::shared_ptr<LogsRing>> _rings;
+	std::mutex _ringsMutex;
+	std::mutex _drainMutex;
+	std::mutex _wakeMutex;
+	std::condition_variable _wake;
+	std::atomic<uint64> _sequence = 0;
+	bool _stopping = false;
+	std::thread _thread;
+
+};
+
+LogsAsyncWriter *LogsAsync = nullptr;
+
 using LogsInMemoryList = QList<QPair<LogDataType, QString>>;
 LogsInMemoryList *LogsInMemory = 0;
 LogsInMemoryList *DeletedLogsInMemory = SharedMemoryLocation<LogsInMemoryList, 0>();
@@ -262,7 +689,12 @@ QString LogsBeforeSingleInstanceChecked; // LogsInMemory already dumped in LogsD
 void _logsWrite(LogDataType type, const QString &msg) {
 	if (LogsData && (type == LogDataMain || LogsStartIndexChosen < 0)) {
 		if (type == LogDataMain || Logs::DebugEnabled()) {
-			LogsData->write(type, msg);
+			if (!LogsAsync || !LogsAsync->push(type, msg)) {
+				if (LogsAsync) {
+					LogsAsync->flush();
+				}
+				LogsData->write(type, msg);
+			}
 		}
 	} else if (LogsInMemory != DeletedLogsInMemory) {
 		if (!LogsInMemory) {
@@ -274,10 +706,24 @@ void _logsWrite(LogDataType type, const QString &msg) {
 	}
 }
 
+void _logsWriteBinary(LogDataType type, const QByteArray &bytes) {
+	// Binary entries are not kept in memory before logs are started.
+	if (!LogsData || LogsStartIndexChosen >= 0 || !Logs::DebugEnabled()) {
+		return;
+	}
+	if (!LogsAsync || !LogsAsync->push(type, bytes.constData(), bytes.size())) {
+		if (LogsAsync) {
+			LogsAsync->flush();
+		}
+		LogsData->write(type, bytes);
+	}
+}
+
 namespace Logs {
 namespace {
 
 bool DebugModeEnabled = false;
+bool MtpBinaryModeEnabled = false;
 
 void MoveOldDataFiles(const QString &wasDir) {
 	QFile data(wasDir + "data"), dataConfig(wasDir + "data_config"), tdataConfig(wasDir + "tdata/config");
@@ -339,6 +785,14 @@ bool DebugEnabled() {
 #endif
 }
 
+void SetMtpBinaryEnabled(bool enabled) {
+	MtpBinaryModeEnabled = enabled;
+}
+
+bool MtpBinaryEnabled() {
+	return MtpBinaryModeEnabled;
+}
+
 bool WritingEntry() {
 	return WritingEntryFlag;
 }
@@ -464,6 +918,7 @@ void start(not_null<Core::Launcher*> launcher) {
 }
 
 void finish() {
+	delete base::take(LogsAsync);
 	delete LogsData;
 	LogsData = 0;
 
@@ -508,6 +963,8 @@ bool instanceChecked() {
 	}
 	LogsInMemory = DeletedLogsInMemory;
 
+	LogsAsync = new LogsAsyncWriter();
+
 	DEBUG_LOG(("Debug logs started."));
 	LogsBeforeSingleInstanceChecked.clear();
 	return true;
@@ -528,11 +985,20 @@ void multipleInstances() {
 
 void closeMain() {
 	LOG(("Explicitly closing main log and finishing crash handlers."));
+	if (LogsAsync) {
+		LogsAsync->flush();
+	}
 	if (LogsData) {
 		LogsData->closeMain();
 	}
 }
 
+void flushOnCrash() {
+	if (LogsAsync) {
+		LogsAsync->flushOnCrash();
+	}
+}
+
 void writeMain(const QString &v) {
 	time_t t = time(NULL);
 	struct tm tm;
@@ -610,7 +1076,28 @@ void writeMtp(int32 dc, const QString &v) {
 	_logsWrite(LogDataMtp, msg);
 }
 
+void writeMtpBinary(
+		int32 dc,
+		uint64 keyId,
+		bool outgoing,
+		const int32 *from,
+		const int32 *end) {
+	auto bytes = QByteArray();
+	MTP::details::AppendBinaryDumpRecord(
+		bytes,
+		QDateTime::currentMSecsSinceEpoch(),
+		dc,
+		keyId,
+		outgoing,
+		from,
+		end);
+	_logsWriteBinary(LogDataMtpBinary, bytes);
+}
+
 QString full() {
+	if (LogsAsync) {
+		LogsAsync->flush();
+	}
 	if (LogsData) {
 		return LogsData->full();
 	}
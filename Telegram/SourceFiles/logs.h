@@ -19,6 +19,10 @@ namespace Logs {
 
 void SetDebugEnabled(bool enabled);
 bool DebugEnabled();
+
+// Write raw MTP buffers to DebugLogs/mtp_*.tlb instead of the text dump.
+void SetMtpBinaryEnabled(bool enabled);
+[[nodiscard]] bool MtpBinaryEnabled();
 [[nodiscard]] bool WritingEntry();
 
 void start(not_null<Core::Launcher*> launcher);
@@ -30,10 +34,20 @@ void multipleInstances();
 
 void closeMain();
 
+// Writes the entries still queued for the writer thread without locks
+// or allocations, called from the crash signal handler.
+void flushOnCrash();
+
 void writeMain(const QString &v);
 void writeDebug(const QString &v);
 void writeTcp(const QString &v);
 void writeMtp(int32 dc, const QString &v);
+void writeMtpBinary(
+	int32 dc,
+	uint64 keyId,
+	bool outgoing,
+	const int32 *from,
+	const int32 *end);
 
 QString full();
 
@@ -82,3 +96,10 @@ inline MemoryBuffer mb(const void *ptr, uint32 size) {
 	}\
 }
 //usage MTP_LOG(dc, ("log: %1 %2").arg(1).arg(2))
+
+#define MTP_BINARY_LOG(dc, keyId, outgoing, from, end) {\
+	if (Logs::DebugEnabled() && Logs::started()) {\
+		Logs::writeMtpBinary(dc, keyId, outgoing, from, end);\
+	}\
+}
+//usage MTP_BINARY_LOG(dc, keyId, false, from, end)
@@ -26,6 +26,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "storage/file_upload.h"
 #include "storage/storage_account.h"
 #include "storage/storage_facade.h"
+#include "storage/storage_shared_media.h"
 #include "storage/storage_account.h"
 #include "data/data_session.h"
 #include "data/data_changes.h"
@@ -164,10 +165,20 @@ Session::Session(
 		local().readRecentMasks();
 		local().readFavedStickers();
 		local().readSavedGifs();
+		local().readSharedMediaCounts();
 		data().stickers().notifyUpdated(Data::StickersType::Stickers);
 		data().stickers().notifyUpdated(Data::StickersType::Masks);
 		data().stickers().notifyUpdated(Data::StickersType::Emoji);
 		data().stickers().notifySavedGifsUpdated();
+
+		storage().sharedMediaCountUpdated(
+		) | rpl::start_with_next([=](
+				const Storage::SharedMediaCountUpdate &update) {
+			local().writeSharedMediaCount(
+				update.peerId,
+				update.type,
+				update.count);
+		}, _lifetime);
 	});
 
 #ifndef TDESKTOP_DISABLE_SPELLCHECK
@@ -0,0 +1,228 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "mtproto/details/mtproto_binary_dump.h"
+
+#include "mtproto/details/mtproto_dump_to_text.h"
+#include "scheme.h"
+
+namespace MTP::details {
+namespace {
+
+constexpr auto kMagic = std::array<char, 4>{ { 'T', 'D', 'M', 'B' } };
+constexpr auto kVersion = int32(2);
+constexpr auto kVersionWithoutOriginalSize = int32(1);
+constexpr auto kHeaderSize = int(kMagic.size() + 2 * sizeof(int32));
+constexpr auto kOutgoingFlag = uint32(0x01);
+constexpr auto kMaxRecordSize = uint32(64 * 1024 * 1024) / sizeof(mtpPrime);
+
+// The text dump shows this much of long byte strings as well.
+constexpr auto kKeepFileBytes = 16;
+
+// msg_id + seq_no + length
+constexpr auto kMessageHeaderSize = 4;
+
+// time + keyId + dcId + flags + size
+constexpr auto kRecordHeaderSizeV1 = int(2 * sizeof(int64) + 3 * sizeof(int32));
+
+// time + keyId + dcId + flags + size + originalSize
+constexpr auto kRecordHeaderSize = int(2 * sizeof(int64) + 4 * sizeof(int32));
+
+template <typename Value>
+void Append(QByteArray &to, Value value) {
+	to.append(reinterpret_cast<const char*>(&value), sizeof(Value));
+}
+
+template <typename Value>
+[[nodiscard]] Value Read(const char *&from) {
+	auto result = Value();
+	memcpy(&result, from, sizeof(Value));
+	from += sizeof(Value);
+	return result;
+}
+
+struct FileBytes {
+	const mtpPrime *from = nullptr;
+	const mtpPrime *till = nullptr;
+};
+
+// Finds the file part of upload requests and their responses.
+[[nodiscard]] FileBytes FindFileBytes(
+		const mtpPrime *from,
+		const mtpPrime *end) {
+	if (end - from <= kMessageHeaderSize) {
+		return {};
+	}
+	auto body = from + kMessageHeaderSize;
+	if (*body == mtpc_rpc_result) {
+		body += 3; // rpc_result + req_msg_id
+	}
+	if (body >= end) {
+		return {};
+	}
+	const auto skip = [&]() -> int {
+		switch (mtpTypeId(*body)) {
+		case mtpc_upload_file: return 3; // type + mtime
+		case mtpc_upload_cdnFile: return 1;
+		case mtpc_upload_saveFilePart: return 4; // file_id + file_part
+		case mtpc_upload_saveBigFilePart: return 5; // + file_total_parts
+		}
+		return 0;
+	}();
+	if (!skip || end - body <= skip) {
+		return {};
+	}
+	const auto bytes = body + skip;
+	const auto first = uint32(*bytes) & 0xFFU;
+	const auto length = (first == 254)
+		? (uint32(*bytes) >> 8)
+		: first;
+	const auto prefix = (first == 254) ? 4U : 1U;
+	const auto primes = (prefix + length + 3) / 4;
+	if (first == 255 || primes > uint32(end - bytes)) {
+		return {};
+	}
+	return { bytes, bytes + primes };
+}
+
+} // namespace
+
+QByteArray BinaryDumpHeader(int32 dayIndex) {
+	auto result = QByteArray();
+	result.reserve(kHeaderSize);
+	result.append(kMagic.data(), kMagic.size());
+	Append(result, kVersion);
+	Append(result, dayIndex);
+	return result;
+}
+
+std::optional<int32> BinaryDumpDayIndex(const QByteArray &header) {
+	if (header.size() < kHeaderSize
+		|| memcmp(header.constData(), kMagic.data(), kMagic.size()) != 0) {
+		return std::nullopt;
+	}
+	auto from = header.constData() + kMagic.size();
+	if (Read<int32>(from) != kVersion) {
+		// Files of other versions are not appended to.
+		return std::nullopt;
+	}
+	return Read<int32>(from);
+}
+
+int BinaryDumpHeaderSize() {
+	return kHeaderSize;
+}
+
+void AppendBinaryDumpRecord(
+		QByteArray &to,
+		int64 time,
+		int32 dcId,
+		uint64 keyId,
+		bool outgoing,
+		const mtpPrime *from,
+		const mtpPrime *end) {
+	const auto originalSize = uint32(end - from);
+	const auto file = FindFileBytes(from, end);
+	auto shortened = std::array<mtpPrime, (kKeepFileBytes + 4) / 4>();
+	const auto fileLength = file.from
+		? (uint32(*file.from) & 0xFFU)
+		: 0U;
+	const auto cutFile = file.from
+		&& (fileLength == 254 || fileLength > kKeepFileBytes);
+	if (cutFile) {
+		const auto bytes = reinterpret_cast<char*>(shortened.data());
+		const auto source = reinterpret_cast<const char*>(file.from);
+		const auto prefix = (fileLength == 254) ? 4 : 1;
+		bytes[0] = char(kKeepFileBytes);
+		memcpy(bytes + 1, source + prefix, kKeepFileBytes);
+	}
+	auto parts = std::array<std::pair<const mtpPrime*, uint32>, 3>();
+	if (cutFile) {
+		parts[0] = { from, uint32(file.from - from) };
+		parts[1] = { shortened.data(), uint32(shortened.size()) };
+		parts[2] = { file.till, uint32(end - file.till) };
+	} else {
+		parts[0] = { from, originalSize };
+	}
+	auto size = uint32();
+	for (const auto &[data, length] : parts) {
+		size += length;
+	}
+
+	to.reserve(to.size() + kRecordHeaderSize + size * sizeof(mtpPrime));
+	Append(to, time);
+	Append(to, keyId);
+	Append(to, dcId);
+	Append(to, outgoing ? kOutgoingFlag : uint32(0));
+	Append(to, size);
+	Append(to, originalSize);
+	for (const auto &[data, length] : parts) {
+		if (length) {
+			to.append(
+				reinterpret_cast<const char*>(data),
+				length * sizeof(mtpPrime));
+		}
+	}
+}
+
+bool ReadBinaryDump(
+		const QByteArray &content,
+		Fn<void(BinaryDumpRecord &&record)> callback) {
+	if (content.size() < kHeaderSize
+		|| memcmp(content.constData(), kMagic.data(), kMagic.size()) != 0) {
+		return false;
+	}
+	auto from = content.constData() + kMagic.size();
+	const auto version = Read<int32>(from);
+	if (version != kVersion && version != kVersionWithoutOriginalSize) {
+		return false;
+	}
+	const auto recordHeaderSize = (version == kVersion)
+		? kRecordHeaderSize
+		: kRecordHeaderSizeV1;
+	from = content.constData() + kHeaderSize;
+	const auto till = content.constData() + content.size();
+	while (till - from >= recordHeaderSize) {
+		auto record = BinaryDumpRecord();
+		record.time = Read<int64>(from);
+		record.keyId = Read<uint64>(from);
+		record.dcId = Read<int32>(from);
+		record.outgoing = (Read<uint32>(from) & kOutgoingFlag);
+		const auto size = Read<uint32>(from);
+		record.originalSize = (version == kVersion)
+			? Read<uint32>(from)
+			: size;
+		if (size > kMaxRecordSize
+			|| (till - from) < int64(size * sizeof(mtpPrime))) {
+			break;
+		}
+		record.data.resize(size);
+		memcpy(record.data.data(), from, size * sizeof(mtpPrime));
+		from += size * sizeof(mtpPrime);
+		callback(std::move(record));
+	}
+	return true;
+}
+
+QString BinaryDumpRecordToText(const BinaryDumpRecord &record) {
+	const auto time = QDateTime::fromMSecsSinceEpoch(record.time);
+	auto from = record.data.constData();
+	const auto end = from + record.data.size();
+	const auto cut = (record.originalSize > uint32(record.data.size()))
+		? QString(" [CUT FROM %1 BYTES]"
+		).arg(record.originalSize * sizeof(mtpPrime))
+		: QString();
+	return QString("[%1] (dc:%2) %3: %4%5 (key:%6)"
+	).arg(time.toString("yyyy.MM.dd hh:mm:ss.zzz")
+	).arg(record.dcId
+	).arg(record.outgoing ? "Send" : "Recv"
+	).arg(DumpToText(from, end)
+	).arg(cut
+	).arg(record.keyId);
+}
+
+} // namespace MTP::details
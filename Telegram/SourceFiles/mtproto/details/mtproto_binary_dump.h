@@ -0,0 +1,51 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "mtproto/core_types.h"
+
+namespace MTP::details {
+
+// Raw TL buffers with a small header, written instead of the text dump
+// when binary MTP logging is enabled. Convert them back to the usual
+// text form offline with BinaryDumpToText (see MtpDumpConverter).
+struct BinaryDumpRecord {
+	int64 time = 0; // Milliseconds since epoch.
+	uint64 keyId = 0;
+	int32 dcId = 0;
+	bool outgoing = false;
+	uint32 originalSize = 0; // In mtpPrime-s, larger if data was cut.
+	QVector<mtpPrime> data; // Starting with msg_id, seq_no and length.
+};
+
+[[nodiscard]] QByteArray BinaryDumpHeader(int32 dayIndex);
+[[nodiscard]] std::optional<int32> BinaryDumpDayIndex(
+	const QByteArray &header);
+[[nodiscard]] int BinaryDumpHeaderSize();
+
+// File parts in upload requests and responses keep only their first
+// bytes, like in the text dump, everything else is written as is.
+// The original size is written in the record header.
+void AppendBinaryDumpRecord(
+	QByteArray &to,
+	int64 time,
+	int32 dcId,
+	uint64 keyId,
+	bool outgoing,
+	const mtpPrime *from,
+	const mtpPrime *end);
+
+// Calls the callback for each complete record, stops on a torn tail.
+// Returns false if the content doesn't start with a valid header.
+bool ReadBinaryDump(
+	const QByteArray &content,
+	Fn<void(BinaryDumpRecord &&record)> callback);
+
+[[nodiscard]] QString BinaryDumpRecordToText(const BinaryDumpRecord &record);
+
+} // namespace MTP::details
@@ -1352,11 +1352,20 @@ void SessionPrivate::handleReceived() {
 		auto from = decryptedInts + kEncryptedHeaderIntsCount;
 		auto end = from + (messageLength / kIntSize);
 		auto sfrom = decryptedInts + 4U; // msg_id + seq_no + length + message
-		MTP_LOG(_shiftedDcId, ("Recv: ")
-			+ DumpToText(sfrom, end)
-			+ QString(" (dc:%1,key:%2)"
-			).arg(AbstractConnection::ProtocolDcDebugId(getProtocolDcId())
-			).arg(_encryptionKey->keyId()));
+		if (Logs::MtpBinaryEnabled()) {
+			MTP_BINARY_LOG(
+				_shiftedDcId,
+				_encryptionKey->keyId(),
+				false,
+				sfrom,
+				end);
+		} else {
+			MTP_LOG(_shiftedDcId, ("Recv: ")
+				+ DumpToText(sfrom, end)
+				+ QString(" (dc:%1,key:%2)"
+				).arg(AbstractConnection::ProtocolDcDebugId(getProtocolDcId())
+				).arg(_encryptionKey->keyId()));
+		}
 
 		const auto registered = _receivedMessageIds.registerMsgId(
 			msgId,
@@ -2611,11 +2620,20 @@ bool SessionPrivate::sendSecureRequest(
 	memcpy(request->data() + 2, &_sessionId, 2 * sizeof(mtpPrime));
 
 	auto from = request->constData() + 4;
-	MTP_LOG(_shiftedDcId, ("Send: ")
-		+ DumpToText(from, from + messageSize)
-		+ QString(" (dc:%1,key:%2)"
-		).arg(AbstractConnection::ProtocolDcDebugId(getProtocolDcId())
-		).arg(_encryptionKey->keyId()));
+	if (Logs::MtpBinaryEnabled()) {
+		MTP_BINARY_LOG(
+			_shiftedDcId,
+			_encryptionKey->keyId(),
+			true,
+			from,
+			from + messageSize);
+	} else {
+		MTP_LOG(_shiftedDcId, ("Send: ")
+			+ DumpToText(from, from + messageSize)
+			+ QString(" (dc:%1,key:%2)"
+			).arg(AbstractConnection::ProtocolDcDebugId(getProtocolDcId())
+			).arg(_encryptionKey->keyId()));
+	}
 
 	uchar encryptedSHA256[32];
 	MTPint128 &msgKey(*(MTPint128*)(encryptedSHA256 + 8));
@@ -33,6 +33,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "tray.h"
 #include "storage/localstorage.h"
 #include "storage/storage_domain.h"
+#include "data/data_histories.h"
+#include "data/data_histories_memory.h"
 #include "data/data_session.h"
 #include "main/main_account.h"
 #include "main/main_domain.h"
@@ -710,10 +712,65 @@ void SetupOpenGL(
 	}, container->lifetime());
 }
 
+void SetupHistoriesMemory(
+		not_null<Window::SessionController*> controller,
+		not_null<Ui::VerticalLayout*> container) {
+	constexpr auto kUnlimited = 0;
+	const auto budgets = std::vector<int>{ 64, 128, 256, 512, 1024, 0 };
+	const auto settings = &Core::App().settings();
+	const auto budget = container->lifetime().make_state<rpl::variable<int>>(
+		settings->historiesMemoryBudget());
+	const auto budgetText = [](int megabytes) {
+		return (megabytes == kUnlimited)
+			? tr::lng_settings_chats_memory_unlimited(tr::now)
+			: Ui::FormatSizeText(int64(megabytes) * 1024 * 1024);
+	};
+	auto label = rpl::combine(
+		controller->session().data().histories().memory().usageValue(),
+		budget->value()
+	) | rpl::map([=](int64 usage, int megabytes) {
+		return tr::lng_settings_chats_memory_usage(
+			tr::now,
+			lt_used,
+			Ui::FormatSizeText(usage),
+			lt_budget,
+			budgetText(megabytes));
+	});
+	const auto button = AddButtonWithLabel(
+		container,
+		tr::lng_settings_chats_memory(),
+		std::move(label),
+		st::settingsButtonNoIcon);
+	button->addClickHandler([=] {
+		const auto current = ranges::find(
+			budgets,
+			settings->historiesMemoryBudget());
+		const auto options = ranges::views::all(
+			budgets
+		) | ranges::views::transform(budgetText) | ranges::to_vector;
+		controller->show(Box([=](not_null<Ui::GenericBox*> box) {
+			const auto save = [=](int index) {
+				settings->setHistoriesMemoryBudget(budgets[index]);
+				*budget = budgets[index];
+				Core::App().saveSettingsDelayed();
+			};
+			SingleChoiceBox(box, {
+				.title = tr::lng_settings_chats_memory(),
+				.options = options,
+				.initialSelection = (current != end(budgets))
+					? int(current - begin(budgets))
+					: 0,
+				.callback = save,
+			});
+		}));
+	});
+}
+
 void SetupPerformance(
 		not_null<Window::SessionController*> controller,
 		not_null<Ui::VerticalLayout*> container) {
 	SetupAnimations(container);
+	SetupHistoriesMemory(controller, container);
 	SetupHardwareAcceleration(container);
 #ifdef Q_OS_WIN
 	SetupANGLE(controller, container);
@@ -13,6 +13,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "base/random.h"
 
 #include <crl/crl_object_on_thread.h>
+#include <future>
 #include <QtCore/QtEndian>
 #include <QtCore/QSaveFile>
 
@@ -22,16 +23,90 @@ namespace {
 
 constexpr char TdfMagic[] = { 'T', 'D', 'F', '$' };
 constexpr auto TdfMagicLen = int(sizeof(TdfMagic));
+constexpr char TdjMagic[] = { 'T', 'D', 'J', '$' };
+constexpr auto TdjMagicLen = int(sizeof(TdjMagic));
 
 constexpr auto kStrongIterationsCount = 100'000;
 
 struct WriteEntry {
 	QString basePath;
 	QString base;
+	std::vector<WritePart> parts;
+	bool journal = false;
+	bool clearJournal = false;
+};
+
+struct PreparedWrite {
 	QByteArray data;
 	QByteArray md5;
 };
 
+struct FileContent {
+	int32 version = 0;
+	QByteArray data;
+	qint64 position = 0;
+};
+
+struct PreloadedFile {
+	MTP::AuthKeyPtr key;
+	std::future<std::optional<FileContent>> content;
+};
+
+base::flat_map<QString, PreloadedFile> Preloaded;
+
+[[nodiscard]] QByteArray PrepareEncryptedData(
+		QByteArray &toEncrypt,
+		const MTP::AuthKeyPtr &key) {
+	// prepare for encryption
+	uint32 size = toEncrypt.size(), fullSize = size;
+	if (fullSize & 0x0F) {
+		fullSize += 0x10 - (fullSize & 0x0F);
+		toEncrypt.resize(fullSize);
+		base::RandomFill(toEncrypt.data() + size, fullSize - size);
+	}
+	*(uint32*)toEncrypt.data() = size;
+	QByteArray encrypted(0x10 + fullSize, Qt::Uninitialized); // 128bit of sha1 - key128, sizeof(data), data
+	hashSha1(toEncrypt.constData(), toEncrypt.size(), encrypted.data());
+	MTP::aesEncryptLocal(toEncrypt.constData(), encrypted.data() + 0x10, fullSize, key, encrypted.constData());
+
+	return encrypted;
+}
+
+// Runs on the writer thread, so that the main thread only serializes.
+[[nodiscard]] PreparedWrite PrepareWrite(std::vector<WritePart> &&parts) {
+	auto result = PreparedWrite();
+	auto buffer = QBuffer(&result.data);
+	const auto opened = buffer.open(QIODevice::WriteOnly);
+	Assert(opened);
+	auto stream = QDataStream(&buffer);
+
+	auto md5 = HashMd5();
+	auto fullSize = 0;
+	for (auto &part : parts) {
+		const auto data = part.key
+			? PrepareEncryptedData(part.data, part.key)
+			: base::take(part.data);
+		stream << data;
+		quint32 len = data.isNull() ? 0xffffffff : data.size();
+		if (QSysInfo::ByteOrder != QSysInfo::BigEndian) {
+			len = qbswap(len);
+		}
+		md5.feed(&len, sizeof(len));
+		md5.feed(data.constData(), data.size());
+		fullSize += sizeof(len) + data.size();
+	}
+	stream.setDevice(nullptr);
+	buffer.close();
+
+	md5.feed(&fullSize, sizeof(fullSize));
+	qint32 version = AppVersion;
+	md5.feed(&version, sizeof(version));
+	md5.feed(TdfMagic, TdfMagicLen);
+
+	result.md5 = QByteArray((const char*)md5.result(), 0x10);
+	return result;
+}
+
 class WriteManager final {
 public:
 	explicit WriteManager(crl::weak_on_thread<WriteManager> weak);
@@ -45,6 +120,9 @@ private:
 	void writeScheduled();
 	bool writeOneScheduledNow();
 	void writeNow(WriteEntry &&entry);
+	void appendNow(WriteEntry &&entry);
+	[[nodiscard]] std::deque<WriteEntry>::iterator findFull(
+		const QString &base);
 
 	template <typename File>
 	[[nodiscard]] bool open(File &file, const WriteEntry &entry, char postfix);
@@ -76,10 +154,23 @@ WriteManager::WriteManager(crl::weak_on_thread<WriteManager> weak)
 : _weak(std::move(weak)) {
 }
 
+std::deque<WriteEntry>::iterator WriteManager::findFull(
+		const QString &base) {
+	return ranges::find_if(_scheduled, [&](const WriteEntry &entry) {
+		return !entry.journal && (entry.base == base);
+	});
+}
+
 void WriteManager::write(WriteEntry &&entry) {
-	const auto i = ranges::find(_scheduled, entry.base, &WriteEntry::base);
+	const auto i = entry.journal
+		? end(_scheduled)
+		: findFull(entry.base);
 	if (i == end(_scheduled)) {
 		_scheduled.push_back(std::move(entry));
+	} else if (entry.clearJournal) {
+		// Journal records scheduled before must be dropped by this write.
+		_scheduled.erase(i);
+		_scheduled.push_back(std::move(entry));
 	} else {
 		*i = std::move(entry);
 	}
@@ -87,14 +178,20 @@ void WriteManager::write(WriteEntry &&entry) {
 }
 
 void WriteManager::writeSync(WriteEntry &&entry) {
-	const auto i = ranges::find(_scheduled, entry.base, &WriteEntry::base);
-	if (i != end(_scheduled)) {
+	if (entry.journal || entry.clearJournal) {
+		writeSyncAll();
+	} else if (const auto i = findFull(entry.base); i != end(_scheduled)) {
 		_scheduled.erase(i);
 	}
 	writeNow(std::move(entry));
 }
 
 void WriteManager::writeNow(WriteEntry &&entry) {
+	if (entry.journal) {
+		appendNow(std::move(entry));
+		return;
+	}
+	const auto prepared = PrepareWrite(std::move(entry.parts));
 	const auto path = [&](char postfix) {
 		return this->path(entry, postfix);
 	};
@@ -102,8 +199,8 @@ void WriteManager::writeNow(WriteEntry &&entry) {
 		return this->open(file, entry, postfix);
 	};
 	const auto write = [&](auto &file) {
-		file.write(entry.data);
-		file.write(entry.md5);
+		file.write(prepared.data);
+		file.write(prepared.md5);
 	};
 	const auto safe = path('s');
 	const auto simple = path('0');
@@ -114,6 +211,9 @@ void WriteManager::writeNow(WriteEntry &&entry) {
 		if (save.commit()) {
 			QFile::remove(simple);
 			QFile::remove(backup);
+			if (entry.clearJournal) {
+				QFile::remove(path('j'));
+			}
 			return;
 		}
 		LOG(("Storage Error: Could not commit '%1'.").arg(safe));
@@ -126,6 +226,9 @@ void WriteManager::writeNow(WriteEntry &&entry) {
 
 		QFile::remove(backup);
 		if (base::Platform::RenameWithOverwrite(simple, safe)) {
+			if (entry.clearJournal) {
+				QFile::remove(path('j'));
+			}
 			return;
 		}
 		QFile::remove(safe);
@@ -135,6 +238,27 @@ void WriteManager::writeNow(WriteEntry &&entry) {
 	}
 }
 
+void WriteManager::appendNow(WriteEntry &&entry) {
+	const auto name = path(entry, 'j');
+	auto file = QFile(name);
+	if (!file.open(QIODevice::Append)) {
+		LOG(("Storage Error: Could not open '%1' for appending.").arg(name));
+		return;
+	}
+	if (!file.size()) {
+		file.write(TdjMagic, TdjMagicLen);
+		const auto version = qint32(AppVersion);
+		file.write((const char*)&version, sizeof(version));
+	}
+	auto stream = QDataStream(&file);
+	stream.setVersion(QDataStream::Qt_5_1);
+	for (auto &part : entry.parts) {
+		stream << (part.key
+			? PrepareEncryptedData(part.data, part.key)
+			: part.data);
+	}
+}
+
 void WriteManager::writeSyncAll() {
 	while (writeOneScheduledNow()) {
 	}
@@ -236,6 +360,162 @@ void AsyncWriteManager::stop() {
 
 AsyncWriteManager Manager;
 
+[[nodiscard]] std::optional<FileContent> ReadFileContent(
+		const QString &name,
+		const QString &basePath) {
+	const auto base = basePath + name;
+
+	// detect order of read attempts
+	QString toTry[2];
+	const auto modern = base + 's';
+	if (QFileInfo::exists(modern)) {
+		toTry[0] = modern;
+	} else {
+		// Legacy way.
+		toTry[0] = base + '0';
+		QFileInfo toTry0(toTry[0]);
+		if (toTry0.exists()) {
+			toTry[1] = basePath + name + '1';
+			QFileInfo toTry1(toTry[1]);
+			if (toTry1.exists()) {
+				QDateTime mod0 = toTry0.lastModified();
+				QDateTime mod1 = toTry1.lastModified();
+				if (mod0 < mod1) {
+					qSwap(toTry[0], toTry[1]);
+				}
+			} else {
+				toTry[1] = QString();
+			}
+		} else {
+			toTry[0][toTry[0].size() - 1] = '1';
+		}
+	}
+	for (int32 i = 0; i < 2; ++i) {
+		QString fname(toTry[i]);
+		if (fname.isEmpty()) break;
+
+		QFile f(fname);
+		if (!f.open(QIODevice::ReadOnly)) {
+			DEBUG_LOG(("App Info: failed to open '%1' for reading"
+				).arg(name));
+			continue;
+		}
+
+		// check magic
+		char magic[TdfMagicLen];
+		if (f.read(magic, TdfMagicLen) != TdfMagicLen) {
+			DEBUG_LOG(("App Info: failed to read magic from '%1'"
+				).arg(name));
+			continue;
+		}
+		if (memcmp(magic, TdfMagic, TdfMagicLen)) {
+			DEBUG_LOG(("App Info: bad magic %1 in '%2'").arg(
+				Logs::mb(magic, TdfMagicLen).str(),
+				name));
+			continue;
+		}
+
+		// read app version
+		qint32 version;
+		if (f.read((char*)&version, sizeof(version)) != sizeof(version)) {
+			DEBUG_LOG(("App Info: failed to read version from '%1'"
+				).arg(name));
+			continue;
+		}
+		if (version > AppVersion) {
+			DEBUG_LOG(("App Info: version too big %1 for '%2', my version %3"
+				).arg(version
+				).arg(name
+				).arg(AppVersion));
+			continue;
+		}
+
+		// read data
+		QByteArray bytes = f.read(f.size());
+		int32 dataSize = bytes.size() - 16;
+		if (dataSize < 0) {
+			DEBUG_LOG(("App Info: bad file '%1', could not read sign part"
+				).arg(name));
+			continue;
+		}
+
+		// check signature
+		HashMd5 md5;
+		md5.feed(bytes.constData(), dataSize);
+		md5.feed(&dataSize, sizeof(dataSize));
+		md5.feed(&version, sizeof(version));
+		md5.feed(magic, TdfMagicLen);
+		if (memcmp(md5.result(), bytes.constData() + dataSize, 16)) {
+			DEBUG_LOG(("App Info: bad file '%1', signature did not match"
+				).arg(name));
+			continue;
+		}
+
+		bytes.resize(dataSize);
+
+		if ((i == 0 && !toTry[1].isEmpty()) || i == 1) {
+			QFile::remove(toTry[1 - i]);
+		}
+
+		return FileContent{ .version = version, .data = std::move(bytes) };
+	}
+	return std::nullopt;
+}
+
+[[nodiscard]] std::optional<FileContent> DecryptFileContent(
+		FileContent &&content,
+		const MTP::AuthKeyPtr &key) {
+	auto buffer = QBuffer(&content.data);
+	buffer.open(QIODevice::ReadOnly);
+	auto stream = QDataStream(&buffer);
+	stream.setVersion(QDataStream::Qt_5_1);
+
+	QByteArray encrypted;
+	stream >> encrypted;
+	stream.setDevice(nullptr);
+	buffer.close();
+
+	EncryptedDescriptor data;
+	if (!DecryptLocal(data, encrypted, key)) {
+		return std::nullopt;
+	}
+	const auto position = data.buffer.pos();
+	data.finish();
+	return FileContent{
+		.version = content.version,
+		.data = base::take(data.data),
+		.position = position,
+	};
+}
+
+void ApplyFileContent(FileReadDescriptor &result, FileContent &&content) {
+	result.version = content.version;
+	result.data = std::move(content.data);
+	result.buffer.setBuffer(&result.data);
+	result.buffer.open(QIODevice::ReadOnly);
+	result.buffer.seek(content.position);
+	result.stream.setDevice(&result.buffer);
+	result.stream.setVersion(QDataStream::Qt_5_1);
+}
+
+[[nodiscard]] std::optional<FileContent> TakePreloaded(
+		const QString &name,
+		const QString &basePath,
+		const MTP::AuthKeyPtr &key) {
+	const auto i = Preloaded.find(basePath + name);
+	if (i == end(Preloaded)) {
+		return std::nullopt;
+	}
+	auto entry = std::move(i->second);
+	Preloaded.erase(i);
+	if (entry.key != key) {
+		return std::nullopt;
+	}
+	// The file could not be read or decrypted in the background,
+	// read it once again here to get the usual logs and cleanup.
+	return entry.content.get();
+}
+
 } // namespace
 
 QString ToFilePart(FileKey val) {
@@ -262,6 +542,10 @@ bool KeyAlreadyUsed(QString &name) {
 	if (QFileInfo::exists(name)) {
 		return true;
 	}
+	name[name.size() - 1] = 'j';
+	if (QFileInfo::exists(name)) {
+		return true;
+	}
 	return false;
 }
 
@@ -288,6 +572,8 @@ void ClearKey(const FileKey &key, const QString &basePath) {
 	QFile::remove(name);
 	name[name.size() - 1] = 's';
 	QFile::remove(name);
+	name[name.size() - 1] = 'j';
+	QFile::remove(name);
 }
 
 bool CheckStreamStatus(QDataStream &stream) {
@@ -398,50 +684,29 @@ FileWriteDescriptor::~FileWriteDescriptor() {
 
 void FileWriteDescriptor::init(const QString &name) {
 	_base = _basePath + name;
-	_buffer.setBuffer(&_safeData);
-	const auto opened = _buffer.open(QIODevice::WriteOnly);
-	Assert(opened);
-	_stream.setDevice(&_buffer);
 }
 
 void FileWriteDescriptor::writeData(const QByteArray &data) {
-	if (!_stream.device()) {
-		return;
-	}
-	_stream << data;
-	quint32 len = data.isNull() ? 0xffffffff : data.size();
-	if (QSysInfo::ByteOrder != QSysInfo::BigEndian) {
-		len = qbswap(len);
-	}
-	_md5.feed(&len, sizeof(len));
-	_md5.feed(data.constData(), data.size());
-	_fullSize += sizeof(len) + data.size();
+	_parts.push_back({ .data = data });
 }
 
 void FileWriteDescriptor::writeEncrypted(
 	EncryptedDescriptor &data,
 	const MTP::AuthKeyPtr &key) {
-	writeData(PrepareEncrypted(data, key));
+	data.finish();
+	_parts.push_back({ .data = base::take(data.data), .key = key });
 }
 
-void FileWriteDescriptor::finish() {
-	if (!_stream.device()) {
-		return;
-	}
-
-	_stream.setDevice(nullptr);
-	_md5.feed(&_fullSize, sizeof(_fullSize));
-	qint32 version = AppVersion;
-	_md5.feed(&version, sizeof(version));
-	_md5.feed(TdfMagic, TdfMagicLen);
-
-	_buffer.close();
+void FileWriteDescriptor::clearJournal() {
+	_clearJournal = true;
+}
 
+void FileWriteDescriptor::finish() {
 	auto entry = WriteEntry{
 		.basePath = _basePath,
 		.base = _base,
-		.data = _safeData,
-		.md5 = QByteArray((const char*)_md5.result(), 0x10)
+		.parts = base::take(_parts),
+		.clearJournal = _clearJournal,
 	};
 	if (_sync) {
 		Manager.writeSync(std::move(entry));
@@ -454,132 +719,27 @@ void FileWriteDescriptor::finish() {
 		EncryptedDescriptor &data,
 		const MTP::AuthKeyPtr &key) {
 	data.finish();
-	QByteArray &toEncrypt(data.data);
-
-	// prepare for encryption
-	uint32 size = toEncrypt.size(), fullSize = size;
-	if (fullSize & 0x0F) {
-		fullSize += 0x10 - (fullSize & 0x0F);
-		toEncrypt.resize(fullSize);
-		base::RandomFill(toEncrypt.data() + size, fullSize - size);
-	}
-	*(uint32*)toEncrypt.data() = size;
-	QByteArray encrypted(0x10 + fullSize, Qt::Uninitialized); // 128bit of sha1 - key128, sizeof(data), data
-	hashSha1(toEncrypt.constData(), toEncrypt.size(), encrypted.data());
-	MTP::aesEncryptLocal(toEncrypt.constData(), encrypted.data() + 0x10, fullSize, key, encrypted.constData());
+	return PrepareEncryptedData(data.data, key);
+}
 
-	return encrypted;
+int EncryptedSize(int size) {
+	// sha1 part + data padded to the AES block size.
+	return 0x10 + ((size + 0x0F) & ~0x0F);
 }
 
 bool ReadFile(
 		FileReadDescriptor &result,
 		const QString &name,
 		const QString &basePath) {
-	const auto base = basePath + name;
-
-	// detect order of read attempts
-	QString toTry[2];
-	const auto modern = base + 's';
-	if (QFileInfo::exists(modern)) {
-		toTry[0] = modern;
-	} else {
-		// Legacy way.
-		toTry[0] = base + '0';
-		QFileInfo toTry0(toTry[0]);
-		if (toTry0.exists()) {
-			toTry[1] = basePath + name + '1';
-			QFileInfo toTry1(toTry[1]);
-			if (toTry1.exists()) {
-				QDateTime mod0 = toTry0.lastModified();
-				QDateTime mod1 = toTry1.lastModified();
-				if (mod0 < mod1) {
-					qSwap(toTry[0], toTry[1]);
-				}
-			} else {
-				toTry[1] = QString();
-			}
-		} else {
-			toTry[0][toTry[0].size() - 1] = '1';
-		}
-	}
-	for (int32 i = 0; i < 2; ++i) {
-		QString fname(toTry[i]);
-		if (fname.isEmpty()) break;
-
-		QFile f(fname);
-		if (!f.open(QIODevice::ReadOnly)) {
-			DEBUG_LOG(("App Info: failed to open '%1' for reading"
-				).arg(name));
-			continue;
-		}
-
-		// check magic
-		char magic[TdfMagicLen];
-		if (f.read(magic, TdfMagicLen) != TdfMagicLen) {
-			DEBUG_LOG(("App Info: failed to read magic from '%1'"
-				).arg(name));
-			continue;
-		}
-		if (memcmp(magic, TdfMagic, TdfMagicLen)) {
-			DEBUG_LOG(("App Info: bad magic %1 in '%2'").arg(
-				Logs::mb(magic, TdfMagicLen).str(),
-				name));
-			continue;
-		}
-
-		// read app version
-		qint32 version;
-		if (f.read((char*)&version, sizeof(version)) != sizeof(version)) {
-			DEBUG_LOG(("App Info: failed to read version from '%1'"
-				).arg(name));
-			continue;
-		}
-		if (version > AppVersion) {
-			DEBUG_LOG(("App Info: version too big %1 for '%2', my version %3"
-				).arg(version
-				).arg(name
-				).arg(AppVersion));
-			continue;
-		}
-
-		// read data
-		QByteArray bytes = f.read(f.size());
-		int32 dataSize = bytes.size() - 16;
-		if (dataSize < 0) {
-			DEBUG_LOG(("App Info: bad file '%1', could not read sign part"
-				).arg(name));
-			continue;
-		}
-
-		// check signature
-		HashMd5 md5;
-		md5.feed(bytes.constData(), dataSize);
-		md5.feed(&dataSize, sizeof(dataSize));
-		md5.feed(&version, sizeof(version));
-		md5.feed(magic, TdfMagicLen);
-		if (memcmp(md5.result(), bytes.constData() + dataSize, 16)) {
-			DEBUG_LOG(("App Info: bad file '%1', signature did not match"
-				).arg(name));
-			continue;
-		}
-
-		bytes.resize(dataSize);
-		result.data = bytes;
-		bytes = QByteArray();
-
-		result.version = version;
-		result.buffer.setBuffer(&result.data);
-		result.buffer.open(QIODevice::ReadOnly);
-		result.stream.setDevice(&result.buffer);
-		result.stream.setVersion(QDataStream::Qt_5_1);
-
-		if ((i == 0 && !toTry[1].isEmpty()) || i == 1) {
-			QFile::remove(toTry[1 - i]);
+	auto content = TakePreloaded(name, basePath, nullptr);
+	if (!content) {
+		content = ReadFileContent(name, basePath);
+		if (!content) {
+			return false;
 		}
-
-		return true;
 	}
-	return false;
+	ApplyFileContent(result, base::take(*content));
+	return true;
 }
 
 bool DecryptLocal(
@@ -626,34 +786,18 @@ bool ReadEncryptedFile(
 		const QString &name,
 		const QString &basePath,
 		const MTP::AuthKeyPtr &key) {
-	if (!ReadFile(result, name, basePath)) {
-		return false;
-	}
-	QByteArray encrypted;
-	result.stream >> encrypted;
-
-	EncryptedDescriptor data;
-	if (!DecryptLocal(data, encrypted, key)) {
-		result.stream.setDevice(nullptr);
-		if (result.buffer.isOpen()) result.buffer.close();
-		result.buffer.setBuffer(nullptr);
-		result.data = QByteArray();
-		result.version = 0;
-		return false;
-	}
-
-	result.stream.setDevice(0);
-	if (result.buffer.isOpen()) {
-		result.buffer.close();
+	auto content = TakePreloaded(name, basePath, key);
+	if (!content) {
+		content = ReadFileContent(name, basePath);
+		if (!content) {
+			return false;
+		}
+		content = DecryptFileContent(base::take(*content), key);
+		if (!content) {
+			return false;
+		}
 	}
-	result.buffer.setBuffer(0);
-	result.data = data.data;
-	result.buffer.setBuffer(&result.data);
-	result.buffer.open(QIODevice::ReadOnly);
-	result.buffer.seek(data.buffer.pos());
-	result.stream.setDevice(&result.buffer);
-	result.stream.setVersion(QDataStream::Qt_5_1);
-
+	ApplyFileContent(result, base::take(*content));
 	return true;
 }
 
@@ -665,6 +809,94 @@ bool ReadEncryptedFile(
 	return ReadEncryptedFile(result, ToFilePart(fkey), basePath, key);
 }
 
+void AppendToJournal(
+		const FileKey &key,
+		const QString &basePath,
+		WritePart &&record) {
+	auto parts = std::vector<WritePart>();
+	parts.push_back(std::move(record));
+	Manager.write(WriteEntry{
+		.basePath = basePath,
+		.base = basePath + ToFilePart(key),
+		.parts = std::move(parts),
+		.journal = true,
+	});
+}
+
+int64 ReadEncryptedJournal(
+		const FileKey &key,
+		const QString &basePath,
+		const MTP::AuthKeyPtr &authKey,
+		Fn<void(EncryptedDescriptor&)> record) {
+	const auto name = basePath + ToFilePart(key) + 'j';
+	auto file = QFile(name);
+	if (!file.open(QIODevice::ReadWrite)) {
+		return 0;
+	}
+	const auto bytes = file.readAll();
+	const auto headerSize = TdjMagicLen + int(sizeof(qint32));
+	if (bytes.size() < headerSize
+		|| memcmp(bytes.constData(), TdjMagic, TdjMagicLen)) {
+		LOG(("App Info: bad journal '%1', removing.").arg(name));
+		file.close();
+		QFile::remove(name);
+		return 0;
+	}
+	auto buffer = QBuffer();
+	buffer.setData(bytes);
+	buffer.open(QIODevice::ReadOnly);
+	buffer.seek(headerSize);
+	auto stream = QDataStream(&buffer);
+	stream.setVersion(QDataStream::Qt_5_1);
+
+	auto valid = int64(headerSize);
+	while (!stream.atEnd()) {
+		auto encrypted = QByteArray();
+		stream >> encrypted;
+		if (stream.status() != QDataStream::Ok) {
+			break;
+		}
+		auto data = EncryptedDescriptor();
+		if (!DecryptLocal(data, encrypted, authKey)) {
+			break;
+		}
+		record(data);
+		valid = buffer.pos();
+	}
+	if (valid < bytes.size()) {
+		LOG(("App Info: journal '%1' cut from %2 to %3 bytes."
+			).arg(name
+			).arg(bytes.size()
+			).arg(valid));
+		file.resize(valid);
+	}
+	return valid;
+}
+
+void PreloadFile(
+		const QString &name,
+		const QString &basePath,
+		const MTP::AuthKeyPtr &key) {
+	auto task = std::make_shared<
+		std::packaged_task<std::optional<FileContent>()>>([=] {
+		auto content = ReadFileContent(name, basePath);
+		return (content && key)
+			? DecryptFileContent(base::take(*content), key)
+			: content;
+	});
+	Preloaded[basePath + name] = PreloadedFile{
+		.key = key,
+		.content = task->get_future(),
+	};
+	crl::async([=] {
+		(*task)();
+	});
+}
+
+void ClearPreloaded() {
+	Preloaded.clear();
+}
+
 void Sync() {
 	Manager.sync();
 }
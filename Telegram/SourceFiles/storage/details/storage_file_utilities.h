@@ -51,6 +51,12 @@ struct EncryptedDescriptor final {
 [[nodiscard]] QByteArray PrepareEncrypted(
 	EncryptedDescriptor &data,
 	const MTP::AuthKeyPtr &key);
+[[nodiscard]] int EncryptedSize(int size);
+
+struct WritePart {
+	QByteArray data;
+	MTP::AuthKeyPtr key; // If set the data is encrypted by the writer.
+};
 
 class FileWriteDescriptor final {
 public:
@@ -69,18 +75,18 @@ public:
 		EncryptedDescriptor &data,
 		const MTP::AuthKeyPtr &key);
 
+	// Journal records are folded into this write, drop them after it.
+	void clearJournal();
+
 private:
 	void init(const QString &name);
 	void finish();
 
 	const QString _basePath;
-	QBuffer _buffer;
-	QDataStream _stream;
-	QByteArray _safeData;
+	std::vector<WritePart> _parts;
 	QString _base;
-	HashMd5 _md5;
-	int _fullSize = 0;
 	bool _sync = false;
+	bool _clearJournal = false;
 
 };
 
@@ -106,6 +112,28 @@ bool ReadEncryptedFile(
 	const QString &basePath,
 	const MTP::AuthKeyPtr &key);
 
+// Journal is a list of separately encrypted records appended next to
+// the key file and replayed on top of it, ordered with its full writes.
+void AppendToJournal(
+	const FileKey &key,
+	const QString &basePath,
+	WritePart &&record);
+
+// Returns the journal size in bytes, a damaged tail is cut off.
+int64 ReadEncryptedJournal(
+	const FileKey &key,
+	const QString &basePath,
+	const MTP::AuthKeyPtr &authKey,
+	Fn<void(EncryptedDescriptor&)> record);
+
+// Starts reading (and decrypting if the key is set) the file on a worker
+// thread, the next ReadFile or ReadEncryptedFile call waits for it.
+void PreloadFile(
+	const QString &name,
+	const QString &basePath,
+	const MTP::AuthKeyPtr &key = nullptr);
+void ClearPreloaded();
+
 void Sync();
 void Finish();
 
@@ -15,6 +15,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/application.h"
 #include "core/file_location.h"
 #include "storage/storage_account.h"
+#include "storage/storage_cache_dedup.h"
 #include "storage/file_download_mtproto.h"
 #include "storage/file_download_web.h"
 #include "platform/platform_file_utilities.h"
@@ -280,7 +281,8 @@ void FileLoader::loadLocal(const Storage::Cache::Key &key) {
 				std::move(image));
 		});
 	};
-	_session->data().cache().get(key, [=, callback = std::move(done)](
+	auto &dedup = _session->data().cacheDedup();
+	dedup.get(key, _cacheTag, [=, callback = std::move(done)](
 			QByteArray &&value) mutable {
 		if (readImage && !value.startsWith("partial:")) {
 			crl::async([
@@ -458,7 +460,7 @@ bool FileLoader::finalizeResult() {
 		if ((_toCache == LoadToCacheAsWell)
 			&& (_data.size() <= Storage::kMaxFileInMemory)
 			&& (key.low || key.high)) {
-			_session->data().cache().put(
+			_session->data().cacheDedup().put(
 				cacheKey(),
 				Storage::Cache::Database::TaggedValue(
 					base::duplicate((!_fullSize || _data.size() == _fullSize)
@@ -1139,6 +1139,12 @@ void writeLangPack() {
 
 	FileWriteDescriptor file(_langPackKey, _basePath);
 	file.writeEncrypted(data, SettingsKey);
+
+	Lang::GetInstance().writeCompiled(langpack);
+}
+
+QString langPackCompiledPath() {
+	return _basePath + u"langpack_compiled"_q;
 }
 
 void saveRecentLanguages(const std::vector<Lang::Language> &list) {
@@ -81,6 +81,7 @@ void clearTheme();
 [[nodiscard]] Window::Theme::Object ReadThemeContent();
 
 void writeLangPack();
+[[nodiscard]] QString langPackCompiledPath();
 void pushRecentLanguage(const Lang::Language &language);
 std::vector<Lang::Language> readRecentLanguages();
 void saveRecentLanguages(const std::vector<Lang::Language> &list);
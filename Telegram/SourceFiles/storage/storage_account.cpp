@@ -11,6 +11,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "storage/storage_domain.h"
 #include "storage/storage_encryption.h"
 #include "storage/storage_clear_legacy.h"
+#include "storage/storage_facade.h"
+#include "storage/storage_shared_media.h"
 #include "storage/cache/storage_cache_types.h"
 #include "storage/details/storage_file_utilities.h"
 #include "storage/details/storage_settings_scheme.h"
@@ -33,6 +35,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_drafts.h"
 #include "export/export_settings.h"
 #include "window/themes/window_theme.h"
+#include "base/unixtime.h"
 
 namespace Storage {
 namespace {
@@ -42,11 +45,23 @@ using Database = Cache::Database;
 
 constexpr auto kDelayedWriteTimeout = crl::time(1000);
 
+constexpr auto kLocationsJournalMinCompact = int64(64 * 1024);
+constexpr auto kLocationsRecordFile = quint32(0x01);
+constexpr auto kLocationsRecordAlias = quint32(0x02);
+constexpr auto kLocationsRecordDownloads = quint32(0x03);
+
 constexpr auto kStickersVersionTag = quint32(-1);
-constexpr auto kStickersSerializeVersion = 3;
+constexpr auto kStickersSerializeVersion = 4;
+constexpr auto kPendingStickerSetsWarmUpDelay = 3 * crl::time(1000);
+constexpr auto kPendingStickerSetsWarmUpStep = crl::time(50);
+constexpr auto kPendingStickerSetsWarmUpChunk = 8;
 constexpr auto kMaxSavedStickerSetsCount = 1000;
 constexpr auto kDefaultStickerInstallDate = TimeId(1);
 
+constexpr auto kSharedMediaCountsVersion = qint32(1);
+constexpr auto kSharedMediaCountsLimit = 4096;
+constexpr auto kSharedMediaCountMaxAge = TimeId(3 * 24 * 60 * 60);
+
 constexpr auto kSinglePeerTypeUserOld = qint32(1);
 constexpr auto kSinglePeerTypeChatOld = qint32(2);
 constexpr auto kSinglePeerTypeChannelOld = qint32(3);
@@ -85,6 +100,7 @@ enum { // Local Storage Keys
 	lskSelfSerialized = 0x15, // serialized self
 	lskMasksKeys = 0x16, // no data
 	lskCustomEmojiKeys = 0x17, // no data
+	lskSharedMediaCounts = 0x18, // no data
 };
 
 auto EmptyMessageDraftSources()
@@ -121,6 +137,65 @@ auto EmptyMessageDraftSources()
 	return cWorkingDir() + qsl("tdata/tdld/");
 }
 
+[[nodiscard]] QByteArray SerializeLocations(
+		const QMultiMap<MediaKey, Core::FileLocation> &locations,
+		const QMap<MediaKey, MediaKey> &aliases,
+		const QByteArray &downloads,
+		const MTP::AuthKeyPtr &key) {
+	quint32 size = 0;
+	for (auto i = locations.cbegin(), e = locations.cend(); i != e; ++i) {
+		// location + type + namelen + name
+		size += sizeof(quint64) * 2 + sizeof(quint32) + Serialize::stringSize(i.value().name());
+		if (AppVersion > 9013) {
+			// bookmark
+			size += Serialize::bytearraySize(i.value().bookmark());
+		}
+		// date + size
+		size += Serialize::dateTimeSize() + sizeof(quint32);
+	}
+
+	//end mark
+	size += sizeof(quint64) * 2 + sizeof(quint32) + Serialize::stringSize(QString());
+	if (AppVersion > 9013) {
+		size += Serialize::bytearraySize(QByteArray());
+	}
+	size += Serialize::dateTimeSize() + sizeof(quint32);
+
+	size += sizeof(quint32); // aliases count
+	for (auto i = aliases.cbegin(), e = aliases.cend(); i != e; ++i) {
+		// alias + location
+		size += sizeof(quint64) * 2 + sizeof(quint64) * 2;
+	}
+
+	size += sizeof(quint32); // legacy webLocationsCount
+	size += Serialize::bytearraySize(downloads);
+
+	EncryptedDescriptor data(size);
+	auto legacyTypeField = 0;
+	for (auto i = locations.cbegin(); i != locations.cend(); ++i) {
+		data.stream << quint64(i.key().first) << quint64(i.key().second) << quint32(legacyTypeField) << i.value().name();
+		if (AppVersion > 9013) {
+			data.stream << i.value().bookmark();
+		}
+		data.stream << i.value().modified << quint32(i.value().size);
+	}
+
+	data.stream << quint64(0) << quint64(0) << quint32(0) << QString();
+	if (AppVersion > 9013) {
+		data.stream << QByteArray();
+	}
+	data.stream << QDateTime::currentDateTime() << quint32(0);
+
+	data.stream << quint32(aliases.size());
+	for (auto i = aliases.cbegin(), e = aliases.cend(); i != e; ++i) {
+		data.stream << quint64(i.key().first) << quint64(i.key().second) << quint64(i.value().first) << quint64(i.value().second);
+	}
+
+	data.stream << quint32(0) << downloads;
+
+	return PrepareEncrypted(data, key);
+}
+
 } // namespace
 
 Account::Account(not_null<Main::Account*> owner, const QString &dataName)
@@ -135,10 +210,17 @@ Account::Account(not_null<Main::Account*> owner, const QString &dataName)
 , _cacheTotalTimeLimit(Database::Settings().totalTimeLimit)
 , _cacheBigFileTotalTimeLimit(Database::Settings().totalTimeLimit)
 , _writeMapTimer([=] { writeMap(); })
-, _writeLocationsTimer([=] { writeLocations(); }) {
+, _writeLocationsTimer([=] { writeLocations(); })
+, _writeSharedMediaCountsTimer([=] { writeSharedMediaCounts(); })
+, _readPendingStickerSetsTimer([=] {
+	readPendingStickerSets(kPendingStickerSetsWarmUpChunk);
+}) {
 }
 
 Account::~Account() {
+	if (_localKey && _sharedMediaCountsChanged) {
+		writeSharedMediaCounts();
+	}
 	if (_localKey && _mapChanged) {
 		writeMap();
 	}
@@ -175,6 +257,12 @@ void Account::startAdded(MTP::AuthKeyPtr localKey) {
 	clearLegacyFiles();
 }
 
+void Account::preload(const MTP::AuthKeyPtr &localKey) const {
+	PreloadFile(qsl("map"), _basePath);
+	PreloadFile(ToFilePart(_dataNameKey), BaseGlobalPath(), localKey);
+	PreloadFile(qsl("config"), _basePath, localKey);
+}
+
 void Account::clearLegacyFiles() {
 	const auto weak = base::make_weak(_owner.get());
 	ClearLegacyFiles(_basePath, [weak, this](
@@ -201,6 +289,7 @@ base::flat_set<QString> Account::collectGoodNames() const {
 		_recentHashtagsAndBotsKey,
 		_exportSettingsKey,
 		_trustedBotsKey,
+		_sharedMediaCountsKey,
 		_installedMasksKey,
 		_recentMasksKey,
 		_archivedMasksKey,
@@ -224,6 +313,8 @@ base::flat_set<QString> Account::collectGoodNames() const {
 		result.emplace(name);
 		name[name.size() - 1] = 's';
 		result.emplace(name);
+		name[name.size() - 1] = 'j';
+		result.emplace(name);
 	};
 	for (const auto &[key, value] : _draftsMap) {
 		push(value);
@@ -285,6 +376,7 @@ Account::ReadMapResult Account::readMapWith(
 	base::flat_map<PeerId, FileKey> draftCursorsMap;
 	base::flat_map<PeerId, bool> draftsNotReadMap;
 	quint64 locationsKey = 0, reportSpamStatusesKey = 0, trustedBotsKey = 0;
+	quint64 sharedMediaCountsKey = 0;
 	quint64 recentStickersKeyOld = 0;
 	quint64 installedStickersKey = 0, featuredStickersKey = 0, recentStickersKey = 0, favedStickersKey = 0, archivedStickersKey = 0;
 	quint64 installedMasksKey = 0, recentMasksKey = 0, archivedMasksKey = 0;
@@ -345,6 +437,9 @@ Account::ReadMapResult Account::readMapWith(
 		case lskTrustedBots: {
 			map.stream >> trustedBotsKey;
 		} break;
+		case lskSharedMediaCounts: {
+			map.stream >> sharedMediaCountsKey;
+		} break;
 		case lskRecentStickersOld: {
 			map.stream >> recentStickersKeyOld;
 		} break;
@@ -414,6 +509,7 @@ Account::ReadMapResult Account::readMapWith(
 
 	_locationsKey = locationsKey;
 	_trustedBotsKey = trustedBotsKey;
+	_sharedMediaCountsKey = sharedMediaCountsKey;
 	_recentStickersKeyOld = recentStickersKeyOld;
 	_installedStickersKey = installedStickersKey;
 	_featuredStickersKey = featuredStickersKey;
@@ -522,6 +618,7 @@ void Account::writeMap() {
 	if (!_draftCursorsMap.empty()) mapSize += sizeof(quint32) * 2 + _draftCursorsMap.size() * sizeof(quint64) * 2;
 	if (_locationsKey) mapSize += sizeof(quint32) + sizeof(quint64);
 	if (_trustedBotsKey) mapSize += sizeof(quint32) + sizeof(quint64);
+	if (_sharedMediaCountsKey) mapSize += sizeof(quint32) + sizeof(quint64);
 	if (_recentStickersKeyOld) mapSize += sizeof(quint32) + sizeof(quint64);
 	if (_installedStickersKey || _featuredStickersKey || _recentStickersKey || _archivedStickersKey) {
 		mapSize += sizeof(quint32) + 4 * sizeof(quint64);
@@ -560,6 +657,9 @@ void Account::writeMap() {
 	if (_trustedBotsKey) {
 		mapData.stream << quint32(lskTrustedBots) << quint64(_trustedBotsKey);
 	}
+	if (_sharedMediaCountsKey) {
+		mapData.stream << quint32(lskSharedMediaCounts) << quint64(_sharedMediaCountsKey);
+	}
 	if (_recentStickersKeyOld) {
 		mapData.stream << quint32(lskRecentStickersOld) << quint64(_recentStickersKeyOld);
 	}
@@ -606,7 +706,7 @@ void Account::reset() {
 	_draftsMap.clear();
 	_draftCursorsMap.clear();
 	_draftsNotReadMap.clear();
-	_locationsKey = _trustedBotsKey = 0;
+	_locationsKey = _trustedBotsKey = _sharedMediaCountsKey = 0;
 	_recentStickersKeyOld = 0;
 	_installedStickersKey = 0;
 	_featuredStickersKey = 0;
@@ -628,6 +728,14 @@ void Account::reset() {
 	_fileLocationAliases.clear();
 	_downloadsSerialize = nullptr;
 	_downloadsSerialized = QByteArray();
+	clearLocationsChanges();
+	_locationsCompactionTail = std::nullopt;
+	_locationsSnapshotSize = _locationsJournalSize = 0;
+	_sharedMediaCounts.clear();
+	_sharedMediaCountsChanged = false;
+	_writeSharedMediaCountsTimer.cancel();
+	_pendingStickerSets.clear();
+	_readPendingStickerSetsTimer.cancel();
 	_cacheTotalSizeLimit = Database::Settings().totalSizeLimit;
 	_cacheTotalTimeLimit = Database::Settings().totalTimeLimit;
 	_cacheBigFileTotalSizeLimit = Database::Settings().totalSizeLimit;
@@ -662,73 +770,251 @@ void Account::writeLocations() {
 	if (_downloadsSerialize) {
 		if (auto serialized = _downloadsSerialize()) {
 			_downloadsSerialized = std::move(*serialized);
+			_changedDownloads = true;
 		}
 	}
 	if (_fileLocations.isEmpty() && _downloadsSerialized.isEmpty()) {
+		clearLocationsChanges();
+		_locationsCompactionTail = std::nullopt;
 		if (_locationsKey) {
 			ClearKey(_locationsKey, _basePath);
 			_locationsKey = 0;
 			writeMapDelayed();
 		}
+	} else if (!_locationsKey) {
+		_locationsKey = GenerateKey(_basePath);
+		writeMapQueued();
+		writeLocationsSnapshot();
+	} else if (!_locationsCompactionTail
+		&& (_locationsJournalSize
+			> std::max(kLocationsJournalMinCompact, _locationsSnapshotSize))) {
+		compactLocations();
 	} else {
-		if (!_locationsKey) {
-			_locationsKey = GenerateKey(_basePath);
-			writeMapQueued();
-		}
-		quint32 size = 0;
-		for (auto i = _fileLocations.cbegin(), e = _fileLocations.cend(); i != e; ++i) {
-			// location + type + namelen + name
-			size += sizeof(quint64) * 2 + sizeof(quint32) + Serialize::stringSize(i.value().name());
-			if (AppVersion > 9013) {
-				// bookmark
-				size += Serialize::bytearraySize(i.value().bookmark());
+		appendLocationsJournal();
+	}
+}
+
+void Account::writeLocationsSnapshot() {
+	Expects(_locationsKey != 0);
+
+	// The changes go to the journal as well, if we crash after the
+	// snapshot is committed but before the journal is removed, replaying
+	// the whole journal on top of the snapshot ends with the same state.
+	_locationsCompactionTail = std::nullopt;
+	appendLocationsJournal();
+
+	const auto encrypted = SerializeLocations(
+		_fileLocations,
+		_fileLocationAliases,
+		_downloadsSerialized,
+		_localKey);
+	_locationsSnapshotSize = encrypted.size();
+	_locationsJournalSize = 0;
+
+	FileWriteDescriptor file(_locationsKey, _basePath);
+	file.clearJournal();
+	file.writeData(encrypted);
+}
+
+void Account::compactLocations() {
+	Expects(_locationsKey != 0);
+
+	// Everything up to now goes to the snapshot, while it is prepared
+	// the new records are both appended and kept to be appended again
+	// after the snapshot write drops the journal. The last changes are
+	// appended as well, see writeLocationsSnapshot().
+	appendLocationsJournal();
+	_locationsCompactionTail.emplace();
+
+	crl::async([
+		=,
+		weak = base::make_weak(_owner.get()),
+		key = _locationsKey,
+		localKey = _localKey,
+		locations = _fileLocations,
+		aliases = _fileLocationAliases,
+		downloads = _downloadsSerialized
+	] {
+		auto encrypted = SerializeLocations(
+			locations,
+			aliases,
+			downloads,
+			localKey);
+		crl::on_main(weak, [=, encrypted = std::move(encrypted)] {
+			if (!_locationsCompactionTail || _locationsKey != key) {
+				return;
 			}
-			// date + size
-			size += Serialize::dateTimeSize() + sizeof(quint32);
-		}
+			const auto tail = base::take(*_locationsCompactionTail);
+			_locationsCompactionTail = std::nullopt;
+			_locationsSnapshotSize = encrypted.size();
+			_locationsJournalSize = 0;
+			{
+				FileWriteDescriptor file(key, _basePath);
+				file.clearJournal();
+				file.writeData(encrypted);
+			}
+			for (const auto &record : tail) {
+				AppendToJournal(key, _basePath, {
+					.data = record,
+					.key = _localKey,
+				});
+				_locationsJournalSize += sizeof(quint32)
+					+ EncryptedSize(record.size());
+			}
+		});
+	});
+}
 
-		//end mark
-		size += sizeof(quint64) * 2 + sizeof(quint32) + Serialize::stringSize(QString());
-		if (AppVersion > 9013) {
-			size += Serialize::bytearraySize(QByteArray());
-		}
-		size += Serialize::dateTimeSize() + sizeof(quint32);
+void Account::appendLocationsJournal() {
+	Expects(_locationsKey != 0);
 
-		size += sizeof(quint32); // aliases count
-		for (auto i = _fileLocationAliases.cbegin(), e = _fileLocationAliases.cend(); i != e; ++i) {
-			// alias + location
-			size += sizeof(quint64) * 2 + sizeof(quint64) * 2;
+	const auto count = _changedLocations.size()
+		+ _changedLocationAliases.size()
+		+ (_changedDownloads ? 1 : 0);
+	if (!count) {
+		return;
+	}
+	const auto enumerate = [&](MediaKey key, auto &&callback) {
+		auto i = _fileLocations.constFind(key);
+		for (; i != _fileLocations.cend() && i.key() == key; ++i) {
+			callback(i.value());
 		}
+	};
 
-		size += sizeof(quint32); // legacy webLocationsCount
-		size += Serialize::bytearraySize(_downloadsSerialized);
+	quint32 size = sizeof(quint32);
+	for (const auto &key : _changedLocations) {
+		// type + location + count
+		size += sizeof(quint32) * 2 + sizeof(quint64) * 2;
+		enumerate(key, [&](const Core::FileLocation &location) {
+			size += Serialize::stringSize(location.name())
+				+ Serialize::bytearraySize(location.bookmark())
+				+ Serialize::dateTimeSize()
+				+ sizeof(qint64);
+		});
+	}
+	// type + alias + location
+	size += (sizeof(quint32) + sizeof(quint64) * 4)
+		* _changedLocationAliases.size();
+	if (_changedDownloads) {
+		size += sizeof(quint32)
+			+ Serialize::bytearraySize(_downloadsSerialized);
+	}
 
-		EncryptedDescriptor data(size);
-		auto legacyTypeField = 0;
-		for (auto i = _fileLocations.cbegin(); i != _fileLocations.cend(); ++i) {
-			data.stream << quint64(i.key().first) << quint64(i.key().second) << quint32(legacyTypeField) << i.value().name();
-			if (AppVersion > 9013) {
-				data.stream << i.value().bookmark();
-			}
-			data.stream << i.value().modified << quint32(i.value().size);
-		}
+	EncryptedDescriptor data(size);
+	data.stream << quint32(count);
+	for (const auto &key : _changedLocations) {
+		auto values = quint32(0);
+		enumerate(key, [&](const Core::FileLocation &) {
+			++values;
+		});
+		data.stream
+			<< kLocationsRecordFile
+			<< quint64(key.first)
+			<< quint64(key.second)
+			<< values;
+		enumerate(key, [&](const Core::FileLocation &location) {
+			data.stream
+				<< location.name()
+				<< location.bookmark()
+				<< location.modified
+				<< qint64(location.size);
+		});
+	}
+	for (const auto &[alias, location] : _changedLocationAliases) {
+		data.stream
+			<< kLocationsRecordAlias
+			<< quint64(alias.first)
+			<< quint64(alias.second)
+			<< quint64(location.first)
+			<< quint64(location.second);
+	}
+	if (_changedDownloads) {
+		data.stream << kLocationsRecordDownloads << _downloadsSerialized;
+	}
+	clearLocationsChanges();
+
+	// Encrypted by the writer thread.
+	data.finish();
+	_locationsJournalSize += sizeof(quint32) + EncryptedSize(data.data.size());
+	if (_locationsCompactionTail) {
+		_locationsCompactionTail->push_back(data.data);
+	}
+	AppendToJournal(_locationsKey, _basePath, {
+		.data = base::take(data.data),
+		.key = _localKey,
+	});
+}
 
-		data.stream << quint64(0) << quint64(0) << quint32(0) << QString();
-		if (AppVersion > 9013) {
-			data.stream << QByteArray();
-		}
-		data.stream << QDateTime::currentDateTime() << quint32(0);
+bool Account::applyLocationsRecord(QDataStream &stream) {
+	auto count = quint32();
+	stream >> count;
+	for (auto i = quint32(); i != count; ++i) {
+		auto type = quint32();
+		stream >> type;
+		switch (type) {
+		case kLocationsRecordFile: {
+			auto first = quint64();
+			auto second = quint64();
+			auto values = quint32();
+			stream >> first >> second >> values;
+			if (!CheckStreamStatus(stream)) {
+				return false;
+			}
+			const auto key = MediaKey(first, second);
+			for (auto j = _fileLocations.find(key)
+				; j != _fileLocations.end() && j.key() == key;) {
+				const auto k = _fileLocationPairs.find(j.value().fname);
+				if (k != _fileLocationPairs.end() && k.value().first == key) {
+					_fileLocationPairs.erase(k);
+				}
+				j = _fileLocations.erase(j);
+			}
+			for (auto j = quint32(); j != values; ++j) {
+				auto location = Core::FileLocation();
+				auto bookmark = QByteArray();
+				auto size = qint64();
+				stream
+					>> location.fname
+					>> bookmark
+					>> location.modified
+					>> size;
+				if (!CheckStreamStatus(stream)) {
+					return false;
+				}
+				location.setBookmark(bookmark);
+				location.size = size;
+				_fileLocations.insert(key, location);
+				if (!location.inMediaCache()) {
+					_fileLocationPairs.insert(location.fname, { key, location });
+				}
+			}
+		} break;
 
-		data.stream << quint32(_fileLocationAliases.size());
-		for (auto i = _fileLocationAliases.cbegin(), e = _fileLocationAliases.cend(); i != e; ++i) {
-			data.stream << quint64(i.key().first) << quint64(i.key().second) << quint64(i.value().first) << quint64(i.value().second);
-		}
+		case kLocationsRecordAlias: {
+			quint64 kfirst, ksecond, vfirst, vsecond;
+			stream >> kfirst >> ksecond >> vfirst >> vsecond;
+			_fileLocationAliases.insert(
+				MediaKey(kfirst, ksecond),
+				MediaKey(vfirst, vsecond));
+		} break;
 
-		data.stream << quint32(0) << _downloadsSerialized;
+		case kLocationsRecordDownloads: {
+			stream >> _downloadsSerialized;
+		} break;
 
-		FileWriteDescriptor file(_locationsKey, _basePath);
-		file.writeEncrypted(data, _localKey);
+		default: return false;
+		}
+		if (!CheckStreamStatus(stream)) {
+			return false;
+		}
 	}
+	return true;
+}
+
+void Account::clearLocationsChanges() {
+	_changedLocations.clear();
+	_changedLocationAliases.clear();
+	_changedDownloads = false;
 }
 
 void Account::writeLocationsQueued() {
@@ -805,6 +1091,17 @@ void Account::readLocations() {
 			}
 		}
 	}
+
+	_locationsSnapshotSize = locations.data.size();
+	_locationsJournalSize = ReadEncryptedJournal(
+		_locationsKey,
+		_basePath,
+		_localKey,
+		[&](EncryptedDescriptor &record) {
+			if (!applyLocationsRecord(record.stream)) {
+				LOG(("App Error: bad record in locations journal."));
+			}
+		});
 }
 
 void Account::updateDownloads(
@@ -1503,11 +1800,15 @@ void Account::writeFileLocation(MediaKey location, const Core::FileLocation &loc
 			if (i.value().second == local) {
 				if (i.value().first != location) {
 					_fileLocationAliases.insert(location, i.value().first);
+					_changedLocationAliases.emplace_back(
+						location,
+						i.value().first);
 					writeLocationsQueued();
 				}
 				return;
 			}
 			if (i.value().first != location) {
+				_changedLocations.emplace(i.value().first);
 				for (auto j = _fileLocations.find(i.value().first), e = _fileLocations.end(); (j != e) && (j.key() == i.value().first); ++j) {
 					if (j.value() == i.value().second) {
 						_fileLocations.erase(j);
@@ -1527,6 +1828,7 @@ void Account::writeFileLocation(MediaKey location, const Core::FileLocation &loc
 		}
 	}
 	_fileLocations.insert(location, local);
+	_changedLocations.emplace(location);
 	writeLocationsQueued();
 }
 
@@ -1538,6 +1840,7 @@ void Account::removeFileLocation(MediaKey location) {
 	while (i != _fileLocations.end() && (i.key() == location)) {
 		i = _fileLocations.erase(i);
 	}
+	_changedLocations.emplace(location);
 	writeLocationsQueued();
 }
 
@@ -1551,6 +1854,7 @@ Core::FileLocation Account::readFileLocation(MediaKey location) {
 		if (!i.value().inMediaCache() && !i.value().check()) {
 			_fileLocationPairs.remove(i.value().fname);
 			i = _fileLocations.erase(i);
+			_changedLocations.emplace(location);
 			writeLocationsDelayed();
 			continue;
 		}
@@ -1645,23 +1949,31 @@ void Account::writeStickerSet(
 	}
 
 	writeInfo(set.stickers.size());
-	for (const auto &sticker : set.stickers) {
-		Serialize::Document::writeToStream(stream, sticker);
-	}
-	stream << qint32(set.dates.size());
-	if (!set.dates.empty()) {
-		Assert(set.dates.size() == set.stickers.size());
-		for (const auto date : set.dates) {
-			stream << qint32(date);
+
+	// The body goes as a separate blob, so that reading it can be deferred.
+	auto body = QByteArray();
+	{
+		auto buffer = QDataStream(&body, QIODevice::WriteOnly);
+		buffer.setVersion(QDataStream::Qt_5_1);
+		for (const auto &sticker : set.stickers) {
+			Serialize::Document::writeToStream(buffer, sticker);
+		}
+		buffer << qint32(set.dates.size());
+		if (!set.dates.empty()) {
+			Assert(set.dates.size() == set.stickers.size());
+			for (const auto date : set.dates) {
+				buffer << qint32(date);
+			}
 		}
-	}
-	stream << qint32(set.emoji.size());
-	for (auto j = set.emoji.cbegin(), e = set.emoji.cend(); j != e; ++j) {
-		stream << j.key()->id() << qint32(j->size());
-		for (const auto sticker : *j) {
-			stream << quint64(sticker->id);
+		buffer << qint32(set.emoji.size());
+		for (auto j = set.emoji.cbegin(), e = set.emoji.cend(); j != e; ++j) {
+			buffer << j.key()->id() << qint32(j->size());
+			for (const auto sticker : *j) {
+				buffer << quint64(sticker->id);
+			}
 		}
 	}
+	stream << body;
 }
 
 // In generic method _writeStickerSets() we look through all the sets and call a
@@ -1680,6 +1992,7 @@ void Account::writeStickerSets(
 		const Data::StickersSetsOrder &order) {
 	using SetFlag = Data::StickersSetFlag;
 
+	_owner->session().data().stickers().loadPendingSets();
 	const auto &sets = _owner->session().data().stickers().sets();
 	if (sets.empty()) {
 		if (stickersKey) {
@@ -1713,6 +2026,7 @@ void Account::writeStickerSets(
 			continue;
 		}
 
+		size += sizeof(quint32); // body size
 		for (const auto sticker : std::as_const(raw->stickers)) {
 			size += Serialize::Document::sizeInStream(sticker);
 		}
@@ -1783,14 +2097,15 @@ void Account::readStickerSets(
 		stickersKey = 0;
 	};
 
-	auto &sets = _owner->session().data().stickers().setsRef();
+	auto &sets = _owner->session().data().stickers().setsRefWithoutPending();
 	if (outOrder) outOrder->clear();
 
 	quint32 versionTag = 0;
 	qint32 version = 0;
 	stickers.stream >> versionTag >> version;
 	if (versionTag != kStickersVersionTag
-		|| (version != 2 && version != kStickersSerializeVersion)) {
+		|| version < 2
+		|| version > kStickersSerializeVersion) {
 		// Old data, without sticker set thumbnails.
 		return failed();
 	}
@@ -1872,7 +2187,6 @@ void Account::readStickerSets(
 			it->second->thumbnailDocumentId = setThumbnailDocumentId;
 		}
 		const auto set = it->second.get();
-		const auto inputSet = set->identifier();
 		const auto fillStickers = set->stickers.isEmpty();
 
 		if (scnt < 0) { // disabled not loaded set
@@ -1880,90 +2194,50 @@ void Account::readStickerSets(
 				set->count = -scnt;
 			}
 			continue;
-		}
-
-		if (fillStickers) {
-			set->stickers.reserve(scnt);
-			set->count = 0;
-		}
-
-		Serialize::Document::StickerSetInfo info(
-			setId,
-			setAccessHash,
-			setShortName);
-		base::flat_set<DocumentId> read;
-		for (int32 j = 0; j < scnt; ++j) {
-			auto document = Serialize::Document::readStickerFromStream(
-				&_owner->session(),
-				stickers.version,
-				stickers.stream, info);
-			if (!CheckStreamStatus(stickers.stream)) {
+		} else if (version < 4) {
+			if (!readStickerSetBody(
+					set,
+					stickers.stream,
+					stickers.version,
+					scnt,
+					fillStickers)) {
 				return failed();
-			} else if (!document
-				|| !document->sticker()
-				|| read.contains(document->id)) {
-				continue;
-			}
-			read.emplace(document->id);
-			if (fillStickers) {
-				set->stickers.push_back(document);
-				if (!(set->flags & SetFlag::Special)) {
-					if (!document->sticker()->set.id) {
-						document->sticker()->set = inputSet;
-					}
-				}
-				++set->count;
 			}
+			continue;
 		}
 
-		qint32 datesCount = 0;
-		stickers.stream >> datesCount;
-		if (datesCount > 0) {
-			if (datesCount != scnt) {
+		auto body = QByteArray();
+		stickers.stream >> body;
+		if (!CheckStreamStatus(stickers.stream)) {
+			return failed();
+		} else if (!fillStickers || _pendingStickerSets.contains(setId)) {
+			continue;
+		} else if (set->flags & SetFlag::Special) {
+			// Recent, faved and custom stickers are needed right away.
+			auto stream = QDataStream(body);
+			stream.setVersion(QDataStream::Qt_5_1);
+			if (!readStickerSetBody(
+					set,
+					stream,
+					stickers.version,
+					scnt,
+					fillStickers)) {
 				return failed();
 			}
-			const auto fillDates =
-				((set->id == Data::Stickers::CloudRecentSetId)
-					|| (set->id == Data::Stickers::CloudRecentAttachedSetId))
-				&& (set->stickers.size() == datesCount);
-			if (fillDates) {
-				set->dates.clear();
-				set->dates.reserve(datesCount);
-			}
-			for (auto i = 0; i != datesCount; ++i) {
-				qint32 date = 0;
-				stickers.stream >> date;
-				if (fillDates) {
-					set->dates.push_back(TimeId(date));
-				}
-			}
-		}
-
-		qint32 emojiCount = 0;
-		stickers.stream >> emojiCount;
-		if (!CheckStreamStatus(stickers.stream) || emojiCount < 0) {
-			return failed();
+			continue;
 		}
-		for (int32 j = 0; j < emojiCount; ++j) {
-			QString emojiString;
-			qint32 stickersCount;
-			stickers.stream >> emojiString >> stickersCount;
-			Data::StickersPack pack;
-			pack.reserve(stickersCount);
-			for (int32 k = 0; k < stickersCount; ++k) {
-				quint64 id;
-				stickers.stream >> id;
-				const auto doc = _owner->session().data().document(id);
-				if (!doc->sticker()) continue;
-
-				pack.push_back(doc);
-			}
-			if (fillStickers) {
-				if (auto emoji = Ui::Emoji::Find(emojiString)) {
-					emoji = emoji->original();
-					set->emoji.insert(emoji, pack);
-				}
-			}
+		set->count = scnt;
+		_pendingStickerSets.emplace(setId, PendingStickerSet{
+			.body = std::move(body),
+			.version = stickers.version,
+			.count = scnt,
+		});
+		if (!_readPendingStickerSetsTimer.isActive()) {
+			_owner->session().data().stickers().setPendingSetsLoader([=] {
+				readPendingStickerSets(-1);
+			});
+			_readPendingStickerSetsTimer.callOnce(
+				kPendingStickerSetsWarmUpDelay);
 		}
 	}
 
@@ -2005,6 +2279,142 @@ void Account::readStickerSets(
 	}
 }
 
+bool Account::readStickerSetBody(
+		not_null<Data::StickersSet*> set,
+		QDataStream &stream,
+		qint32 version,
+		qint32 scnt,
+		bool fillStickers) {
+	using SetFlag = Data::StickersSetFlag;
+
+	const auto inputSet = set->identifier();
+	if (fillStickers) {
+		set->stickers.reserve(scnt);
+		set->count = 0;
+	}
+
+	Serialize::Document::StickerSetInfo info(
+		set->id,
+		set->accessHash,
+		set->shortName);
+	base::flat_set<DocumentId> read;
+	for (int32 j = 0; j < scnt; ++j) {
+		auto document = Serialize::Document::readStickerFromStream(
+			&_owner->session(),
+			version,
+			stream, info);
+		if (!CheckStreamStatus(stream)) {
+			return false;
+		} else if (!document
+			|| !document->sticker()
+			|| read.contains(document->id)) {
+			continue;
+		}
+		read.emplace(document->id);
+		if (fillStickers) {
+			set->stickers.push_back(document);
+			if (!(set->flags & SetFlag::Special)) {
+				if (!document->sticker()->set.id) {
+					document->sticker()->set = inputSet;
+				}
+			}
+			++set->count;
+		}
+	}
+
+	qint32 datesCount = 0;
+	stream >> datesCount;
+	if (datesCount > 0) {
+		if (datesCount != scnt) {
+			return false;
+		}
+		const auto fillDates =
+			((set->id == Data::Stickers::CloudRecentSetId)
+				|| (set->id == Data::Stickers::CloudRecentAttachedSetId))
+			&& (set->stickers.size() == datesCount);
+		if (fillDates) {
+			set->dates.clear();
+			set->dates.reserve(datesCount);
+		}
+		for (auto i = 0; i != datesCount; ++i) {
+			qint32 date = 0;
+			stream >> date;
+			if (fillDates) {
+				set->dates.push_back(TimeId(date));
+			}
+		}
+	}
+
+	qint32 emojiCount = 0;
+	stream >> emojiCount;
+	if (!CheckStreamStatus(stream) || emojiCount < 0) {
+		return false;
+	}
+	for (int32 j = 0; j < emojiCount; ++j) {
+		QString emojiString;
+		qint32 stickersCount;
+		stream >> emojiString >> stickersCount;
+		Data::StickersPack pack;
+		pack.reserve(stickersCount);
+		for (int32 k = 0; k < stickersCount; ++k) {
+			quint64 id;
+			stream >> id;
+			const auto doc = _owner->session().data().document(id);
+			if (!doc->sticker()) continue;
+
+			pack.push_back(doc);
+		}
+		if (fillStickers) {
+			if (auto emoji = Ui::Emoji::Find(emojiString)) {
+				emoji = emoji->original();
+				set->emoji.insert(emoji, pack);
+			}
+		}
+	}
+	return CheckStreamStatus(stream);
+}
+
+void Account::readPendingStickerSets(int limit) {
+	if (!_owner->sessionExists()) {
+		_pendingStickerSets.clear();
+		return;
+	}
+	const auto session = &_owner->session();
+	const auto &sets = session->data().stickers().sets();
+	while (!_pendingStickerSets.empty() && limit-- != 0) {
+		const auto setId = _pendingStickerSets.back().first;
+		auto pending = std::move(_pendingStickerSets.back().second);
+		_pendingStickerSets.pop_back();
+
+		const auto i = sets.find(setId);
+		if (i == end(sets) || !i->second->stickers.isEmpty()) {
+			continue;
+		}
+		auto stream = QDataStream(pending.body);
+		stream.setVersion(QDataStream::Qt_5_1);
+		if (!readStickerSetBody(
+				i->second.get(),
+				stream,
+				pending.version,
+				pending.count,
+				true)) {
+			LOG(("App Error: could not read sticker set %1.").arg(setId));
+		}
+	}
+	if (!_pendingStickerSets.empty()) {
+		_readPendingStickerSetsTimer.callOnce(kPendingStickerSetsWarmUpStep);
+		return;
+	}
+	_readPendingStickerSetsTimer.cancel();
+	session->data().stickers().setPendingSetsLoader(nullptr);
+	crl::on_main(session, [=] {
+		auto &stickers = session->data().stickers();
+		stickers.notifyUpdated(Data::StickersType::Stickers);
+		stickers.notifyUpdated(Data::StickersType::Masks);
+		stickers.notifyUpdated(Data::StickersType::Emoji);
+	});
+}
+
 void Account::writeInstalledStickers() {
 	using SetFlag = Data::StickersSetFlag;
 
@@ -2282,7 +2692,9 @@ void Account::readInstalledStickers() {
 		return importOldRecentStickers();
 	}
 
-	_owner->session().data().stickers().setsRef().clear();
+	_pendingStickerSets.clear();
+	_readPendingStickerSetsTimer.cancel();
+	_owner->session().data().stickers().setsRefWithoutPending().clear();
 	readStickerSets(
 		_installedStickersKey,
 		&_owner->session().data().stickers().setsOrderRef(),
@@ -2906,6 +3318,129 @@ bool Account::isBotTrustedOpenWebView(PeerId botId) {
 		&& ((i->second & BotTrustFlag::OpenWebView) != 0);
 }
 
+void Account::writeSharedMediaCount(
+		PeerId peerId,
+		SharedMediaType type,
+		std::optional<int> count) {
+	const auto key = std::make_pair(peerId, type);
+	if (count) {
+		_sharedMediaCounts[key] = SharedMediaCount{
+			.count = *count,
+			.updated = base::unixtime::now(),
+		};
+	} else if (!_sharedMediaCounts.contains(key)) {
+		return;
+	} else {
+		_sharedMediaCounts.remove(key);
+	}
+	_sharedMediaCountsChanged = true;
+	_writeSharedMediaCountsTimer.callOnce(kDelayedWriteTimeout);
+}
+
+void Account::writeSharedMediaCounts() {
+	_writeSharedMediaCountsTimer.cancel();
+	if (!_sharedMediaCountsChanged) {
+		return;
+	}
+	_sharedMediaCountsChanged = false;
+
+	if (_sharedMediaCounts.size() > kSharedMediaCountsLimit) {
+		auto dates = std::vector<TimeId>();
+		dates.reserve(_sharedMediaCounts.size());
+		for (const auto &[key, value] : _sharedMediaCounts) {
+			dates.push_back(value.updated);
+		}
+		const auto nth = end(dates) - kSharedMediaCountsLimit;
+		ranges::nth_element(dates, nth);
+		const auto border = *nth;
+		auto i = begin(_sharedMediaCounts);
+		while (i != end(_sharedMediaCounts)) {
+			if (i->second.updated < border) {
+				i = _sharedMediaCounts.erase(i);
+			} else {
+				++i;
+			}
+		}
+	}
+	if (_sharedMediaCounts.empty()) {
+		if (_sharedMediaCountsKey) {
+			ClearKey(_sharedMediaCountsKey, _basePath);
+			_sharedMediaCountsKey = 0;
+			writeMapDelayed();
+		}
+		return;
+	}
+	if (!_sharedMediaCountsKey) {
+		_sharedMediaCountsKey = GenerateKey(_basePath);
+		writeMapQueued();
+	}
+	quint32 size = sizeof(qint32) * 2
+		+ _sharedMediaCounts.size() * (sizeof(quint64) + sizeof(qint32) * 3);
+	EncryptedDescriptor data(size);
+	data.stream
+		<< kSharedMediaCountsVersion
+		<< qint32(_sharedMediaCounts.size());
+	for (const auto &[key, value] : _sharedMediaCounts) {
+		data.stream
+			<< SerializePeerId(key.first)
+			<< qint32(key.second)
+			<< qint32(value.count)
+			<< qint32(value.updated);
+	}
+
+	FileWriteDescriptor file(_sharedMediaCountsKey, _basePath);
+	file.writeEncrypted(data, _localKey);
+}
+
+void Account::readSharedMediaCounts() {
+	if (!_sharedMediaCountsKey) return;
+
+	FileReadDescriptor counts;
+	if (!ReadEncryptedFile(counts, _sharedMediaCountsKey, _basePath, _localKey)) {
+		ClearKey(_sharedMediaCountsKey, _basePath);
+		_sharedMediaCountsKey = 0;
+		writeMapDelayed();
+		return;
+	}
+
+	auto version = qint32();
+	auto size = qint32();
+	counts.stream >> version >> size;
+	if (version != kSharedMediaCountsVersion) {
+		_sharedMediaCountsChanged = true;
+		writeSharedMediaCounts();
+		return;
+	}
+	const auto now = base::unixtime::now();
+	auto &storage = _owner->session().storage();
+	for (auto i = 0; i != size; ++i) {
+		auto peerIdSerialized = quint64();
+		auto type = qint32();
+		auto count = qint32();
+		auto updated = qint32();
+		counts.stream >> peerIdSerialized >> type >> count >> updated;
+		if (!CheckStreamStatus(counts.stream)) {
+			break;
+		}
+		const auto peerId = DeserializePeerId(peerIdSerialized);
+		const auto mediaType = static_cast<SharedMediaType>(type);
+		if (!peerId
+			|| !IsValidSharedMediaType(mediaType)
+			|| count < 0
+			|| updated + kSharedMediaCountMaxAge < now) {
+			_sharedMediaCountsChanged = true;
+			continue;
+		}
+		_sharedMediaCounts.emplace(
+			std::make_pair(peerId, mediaType),
+			SharedMediaCount{ .count = count, .updated = updated });
+		storage.restoreSharedMediaCount(peerId, mediaType, count);
+	}
+	if (_sharedMediaCountsChanged) {
+		_writeSharedMediaCountsTimer.callOnce(kDelayedWriteTimeout);
+	}
+}
+
 bool Account::encrypt(
 		const void *src,
 		void *dst,
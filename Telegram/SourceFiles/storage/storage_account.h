@@ -46,6 +46,8 @@ struct FileReadDescriptor;
 
 class EncryptionKey;
 
+enum class SharedMediaType : signed char;
+
 using FileKey = quint64;
 
 enum class StartResult : uchar;
@@ -70,6 +72,7 @@ public:
 	[[nodiscard]] std::unique_ptr<MTP::Config> start(
 		MTP::AuthKeyPtr localKey);
 	void startAdded(MTP::AuthKeyPtr localKey);
+	void preload(const MTP::AuthKeyPtr &localKey) const;
 	[[nodiscard]] int oldMapVersion() const {
 		return _oldMapVersion;
 	}
@@ -164,6 +167,12 @@ public:
 	void markBotTrustedOpenWebView(PeerId botId);
 	[[nodiscard]] bool isBotTrustedOpenWebView(PeerId botId);
 
+	void readSharedMediaCounts();
+	void writeSharedMediaCount(
+		PeerId peerId,
+		SharedMediaType type,
+		std::optional<int> count);
+
 	[[nodiscard]] bool encrypt(
 		const void *src,
 		void *dst,
@@ -189,6 +198,10 @@ private:
 		OpenWebView = (1 << 2),
 	};
 	friend inline constexpr bool is_flag_type(BotTrustFlag) { return true; };
+	struct SharedMediaCount {
+		int count = 0;
+		TimeId updated = 0;
+	};
 
 	[[nodiscard]] base::flat_set<QString> collectGoodNames() const;
 	[[nodiscard]] auto prepareReadSettingsContext() const
@@ -206,6 +219,11 @@ private:
 	void writeLocations();
 	void writeLocationsQueued();
 	void writeLocationsDelayed();
+	void writeLocationsSnapshot();
+	void compactLocations();
+	void appendLocationsJournal();
+	bool applyLocationsRecord(QDataStream &stream);
+	void clearLocationsChanges();
 
 	std::unique_ptr<Main::SessionSettings> readSessionSettings();
 	void writeSessionSettings(Main::SessionSettings *stored);
@@ -239,11 +257,22 @@ private:
 		FileKey &stickersKey,
 		Data::StickersSetsOrder *outOrder = nullptr,
 		Data::StickersSetFlags readingFlags = 0);
+	[[nodiscard]] bool readStickerSetBody(
+		not_null<Data::StickersSet*> set,
+		QDataStream &stream,
+		qint32 version,
+		qint32 scnt,
+		bool fillStickers);
+
+	// Negative limit reads all the pending sets at once.
+	void readPendingStickerSets(int limit);
 	void importOldRecentStickers();
 
 	void readTrustedBots();
 	void writeTrustedBots();
 
+	void writeSharedMediaCounts();
+
 	std::optional<RecentHashtagPack> saveRecentHashtags(
 		Fn<RecentHashtagPack()> getPack,
 		const QString &text);
@@ -271,8 +300,18 @@ private:
 	QByteArray _downloadsSerialized;
 	Fn<std::optional<QByteArray>()> _downloadsSerialize;
 
+	base::flat_set<MediaKey> _changedLocations;
+	std::vector<std::pair<MediaKey, MediaKey>> _changedLocationAliases;
+	bool _changedDownloads = false;
+	int64 _locationsSnapshotSize = 0;
+	int64 _locationsJournalSize = 0;
+	// Journal records appended while a snapshot is prepared, before the
+	// encryption, that is done by the writer thread.
+	std::optional<std::vector<QByteArray>> _locationsCompactionTail;
+
 	FileKey _locationsKey = 0;
 	FileKey _trustedBotsKey = 0;
+	FileKey _sharedMediaCountsKey = 0;
 	FileKey _installedStickersKey = 0;
 	FileKey _featuredStickersKey = 0;
 	FileKey _recentStickersKey = 0;
@@ -299,15 +338,29 @@ private:
 
 	base::flat_map<PeerId, base::flags<BotTrustFlag>> _trustedBots;
 	bool _trustedBotsRead = false;
+	base::flat_map<
+		std::pair<PeerId, SharedMediaType>,
+		SharedMediaCount> _sharedMediaCounts;
 	bool _readingUserSettings = false;
 	bool _recentHashtagsAndBotsWereRead = false;
 
+	// Sticker set bodies kept serialized until the set is needed.
+	struct PendingStickerSet {
+		QByteArray body;
+		qint32 version = 0;
+		qint32 count = 0;
+	};
+	base::flat_map<uint64, PendingStickerSet> _pendingStickerSets;
+
 	int _oldMapVersion = 0;
 
 	base::Timer _writeMapTimer;
 	base::Timer _writeLocationsTimer;
+	base::Timer _writeSharedMediaCountsTimer;
+	base::Timer _readPendingStickerSetsTimer;
 	bool _mapChanged = false;
 	bool _locationsChanged = false;
+	bool _sharedMediaCountsChanged = false;
 
 };
 
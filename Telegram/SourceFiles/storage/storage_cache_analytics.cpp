@@ -0,0 +1,423 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "storage/storage_cache_analytics.h"
+
+#include "data/data_types.h"
+
+namespace Storage {
+namespace {
+
+constexpr auto kSerializeVersion = 2;
+constexpr auto kMaxEntries = 16 * 1024;
+
+// The entries take hundreds of kilobytes and change on every file access,
+// they are written rarely and on exit. Losing some of them is harmless.
+constexpr auto kSaveEntriesDelay = 10 * 60 * crl::time(1000);
+constexpr auto kSaveHitsDelay = 10 * crl::time(1000);
+
+// Start removing entries at 90% of the limit and go down to 80%, before
+// the database itself starts evicting the least recently used ones.
+constexpr auto kEvictThreshold = 0.9;
+constexpr auto kEvictTarget = 0.8;
+
+// The database stats are updated with a delay, don't evict twice.
+// After the pause the real size is checked again, because some of the
+// entries could be already removed by the database itself.
+constexpr auto kEvictPause = 10 * crl::time(1000);
+
+// Every request costs a round trip, counted as this many bytes.
+constexpr auto kRequestCost = 64. * 1024;
+
+[[nodiscard]] double TagCostWeight(uint8 tag) {
+	// Stickers and animations are shown again and again in chats,
+	// a miss on them is seen by the user much more often.
+	switch (tag) {
+	case Data::kStickerCacheTag: return 4.;
+	case Data::kAnimationCacheTag: return 2.;
+	}
+	return 1.;
+}
+
+[[nodiscard]] double DownloadCost(uint8 tag, int64 size) {
+	return TagCostWeight(tag) * (kRequestCost + double(size));
+}
+
+} // namespace
+
+CacheAnalytics::CacheAnalytics(
+	not_null<Cache::Database*> cache,
+	Fn<int64()> sizeLimit)
+: _cache(cache)
+, _sizeLimit(std::move(sizeLimit))
+, _recheckTimer([=] { checkSize(_totalSize); })
+, _saveEntriesTimer([=] { saveEntries(); })
+, _saveHitsTimer([=] { saveHits(); }) {
+	load();
+
+	_cache->statsOnMain(
+	) | rpl::start_with_next([=](const Cache::Database::Stats &stats) {
+		forgetCleared(stats);
+		if (!stats.clearing) {
+			checkSize(stats.full.totalSize);
+		}
+	}, _lifetime);
+}
+
+CacheAnalytics::~CacheAnalytics() {
+	if (_saveEntriesTimer.isActive()) {
+		saveEntries();
+	}
+	if (_saveHitsTimer.isActive()) {
+		saveHits();
+	}
+}
+
+void CacheAnalytics::stored(const Cache::Key &key, uint8 tag, int64 size) {
+	// A new value replaces the old one, the frequency starts again.
+	_entries.remove(key);
+	touch(key, tag, size, 1);
+}
+
+void CacheAnalytics::used(const Cache::Key &key, uint8 tag, int64 size) {
+	touch(key, tag, size, 1);
+}
+
+void CacheAnalytics::hit(const Cache::Key &key, uint8 tag, int64 size) {
+	touch(key, tag, size, 1);
+	countHit(tag, true);
+}
+
+void CacheAnalytics::missed(uint8 tag) {
+	countHit(tag, false);
+}
+
+CacheTagHits CacheAnalytics::hits(uint8 tag) const {
+	const auto i = _hits.find(tag);
+	return (i != end(_hits)) ? i->second : CacheTagHits();
+}
+
+rpl::producer<CacheTagHits> CacheAnalytics::hitsValue(uint8 tag) const {
+	return rpl::single(tag) | rpl::then(
+		_hitsUpdates.events() | rpl::filter(rpl::mappers::_1 == tag)
+	) | rpl::map([=](uint8) {
+		return hits(tag);
+	});
+}
+
+rpl::producer<Cache::Key> CacheAnalytics::evicted() const {
+	return _evicted.events();
+}
+
+rpl::producer<uint8> CacheAnalytics::tagCleared() const {
+	return _tagCleared.events();
+}
+
+void CacheAnalytics::touch(
+		const Cache::Key &key,
+		uint8 tag,
+		int64 size,
+		int add) {
+	if (size <= 0) {
+		return;
+	}
+	auto &entry = _entries[key];
+	entry.tag = tag;
+	entry.size = size;
+	entry.frequency += add;
+	entry.priority = computePriority(entry);
+	if (_entries.size() > kMaxEntries) {
+		trimEntries();
+	}
+	saveEntriesDelayed();
+}
+
+double CacheAnalytics::computePriority(const Entry &entry) const {
+	Expects(entry.size > 0);
+
+	return _inflation
+		+ entry.frequency * DownloadCost(entry.tag, entry.size) / entry.size;
+}
+
+void CacheAnalytics::countHit(uint8 tag, bool hit) {
+	auto &hits = _hits[tag];
+	++(hit ? hits.hits : hits.misses);
+	_hitsUpdates.fire_copy(tag);
+	saveHitsDelayed();
+}
+
+void CacheAnalytics::forgetCleared(const Cache::Database::Stats &stats) {
+	// Entries of a cleared database or of a tag cleared in the storage
+	// settings would be evicted first without freeing anything.
+	const auto was = _entries.size();
+	if (stats.clearing) {
+		_entries.clear();
+	} else {
+		auto cleared = base::flat_set<uint8>();
+		for (const auto &[tag, count] : _taggedCounts) {
+			const auto i = stats.tagged.find(tag);
+			if (count > 0 && (i == end(stats.tagged) || !i->second.count)) {
+				cleared.emplace(tag);
+			}
+		}
+		if (!cleared.empty()) {
+			for (auto i = begin(_entries); i != end(_entries);) {
+				if (cleared.contains(i->second.tag)) {
+					i = _entries.erase(i);
+				} else {
+					++i;
+				}
+			}
+			for (const auto tag : cleared) {
+				_tagCleared.fire_copy(tag);
+			}
+		}
+	}
+	_taggedCounts.clear();
+	for (const auto &[tag, summary] : stats.tagged) {
+		_taggedCounts.emplace(tag, summary.count);
+	}
+	if (_entries.size() != was) {
+		saveEntriesDelayed();
+	}
+}
+
+void CacheAnalytics::checkSize(int64 totalSize) {
+	_totalSize = totalSize;
+	const auto limit = _sizeLimit();
+	if (!_entriesLoaded
+		|| limit <= 0
+		|| totalSize <= int64(limit * kEvictThreshold)
+		|| (_evictedAt && crl::now() - _evictedAt < kEvictPause)) {
+		return;
+	}
+	evict(totalSize, limit);
+}
+
+void CacheAnalytics::evict(int64 totalSize, int64 limit) {
+	using Pair = std::pair<double, Cache::Key>;
+	auto order = std::vector<Pair>();
+	order.reserve(_entries.size());
+	for (const auto &[key, entry] : _entries) {
+		order.emplace_back(entry.priority, key);
+	}
+	ranges::sort(order, ranges::less(), &Pair::first);
+
+	const auto target = int64(limit * kEvictTarget);
+	auto removed = 0;
+	auto removedSize = int64();
+	for (const auto &[priority, key] : order) {
+		if (totalSize - removedSize <= target) {
+			break;
+		}
+		const auto i = _entries.find(key);
+		removedSize += i->second.size;
+		_inflation = std::max(_inflation, priority);
+		_entries.erase(i);
+		_cache->remove(key);
+		_evicted.fire_copy(key);
+		++removed;
+	}
+	_evictedAt = crl::now();
+	if (removed) {
+		_recheckTimer.callOnce(2 * kEvictPause);
+		LOG(("Cache Info: Evicted %1 entries, %2 bytes, inflation %3."
+			).arg(removed
+			).arg(removedSize
+			).arg(_inflation));
+		saveEntriesDelayed();
+	}
+}
+
+void CacheAnalytics::trimEntries() {
+	// Forget about the least valuable entries, the database still keeps
+	// them and evicts them by its own time and size limits.
+	using Pair = std::pair<double, Cache::Key>;
+	auto order = std::vector<Pair>();
+	order.reserve(_entries.size());
+	for (const auto &[key, entry] : _entries) {
+		order.emplace_back(entry.priority, key);
+	}
+	ranges::sort(order, ranges::less(), &Pair::first);
+	const auto drop = int(_entries.size()) - (kMaxEntries * 7 / 8);
+	for (auto i = 0; i < drop; ++i) {
+		_entries.remove(order[i].second);
+	}
+}
+
+void CacheAnalytics::load() {
+	const auto weak = base::make_weak(this);
+	_cache->get(Data::CacheAnalyticsKey(), [=](QByteArray &&value) {
+		crl::on_main(weak, [=, value = std::move(value)] {
+			applyLoadedEntries(value);
+		});
+	});
+	_cache->get(Data::CacheHitsKey(), [=](QByteArray &&value) {
+		crl::on_main(weak, [=, value = std::move(value)] {
+			applyLoadedHits(value);
+		});
+	});
+}
+
+void CacheAnalytics::applyLoadedEntries(const QByteArray &serialized) {
+	_entriesLoaded = true;
+	if (serialized.isEmpty()) {
+		return;
+	}
+	QDataStream stream(serialized);
+	stream.setVersion(QDataStream::Qt_5_1);
+
+	auto version = qint32();
+	auto inflation = double();
+	auto count = qint32();
+	stream >> version >> inflation >> count;
+	if (stream.status() != QDataStream::Ok
+		|| version != kSerializeVersion
+		|| count < 0
+		|| count > kMaxEntries) {
+		return;
+	}
+	auto entries = std::vector<std::pair<Cache::Key, Entry>>();
+	entries.reserve(count);
+	for (auto i = 0; i != count; ++i) {
+		auto high = quint64();
+		auto low = quint64();
+		auto priority = double();
+		auto size = qint64();
+		auto frequency = qint32();
+		auto tag = quint8();
+		stream >> high >> low >> priority >> size >> frequency >> tag;
+		entries.push_back({ Cache::Key{ high, low }, Entry{
+			.priority = priority,
+			.size = size,
+			.frequency = frequency,
+			.tag = tag,
+		} });
+	}
+	if (stream.status() != QDataStream::Ok) {
+		return;
+	}
+
+	// Keep what was counted in this session before the load finished.
+	_inflation = std::max(_inflation, inflation);
+	for (const auto &[key, entry] : entries) {
+		if (entry.size > 0) {
+			_entries.emplace(key, entry);
+		}
+	}
+}
+
+void CacheAnalytics::applyLoadedHits(const QByteArray &serialized) {
+	_hitsLoaded = true;
+	if (serialized.isEmpty()) {
+		return;
+	}
+	QDataStream stream(serialized);
+	stream.setVersion(QDataStream::Qt_5_1);
+
+	auto version = qint32();
+	auto tagsCount = qint32();
+	stream >> version >> tagsCount;
+	if (stream.status() != QDataStream::Ok
+		|| version != kSerializeVersion
+		|| tagsCount < 0
+		|| tagsCount > 256) {
+		return;
+	}
+	auto hits = base::flat_map<uint8, CacheTagHits>();
+	for (auto i = 0; i != tagsCount; ++i) {
+		auto tag = quint8();
+		auto tagHits = qint64();
+		auto tagMisses = qint64();
+		stream >> tag >> tagHits >> tagMisses;
+		hits[tag] = { .hits = tagHits, .misses = tagMisses };
+	}
+	if (stream.status() != QDataStream::Ok) {
+		return;
+	}
+	for (const auto &[tag, loaded] : hits) {
+		auto &now = _hits[tag];
+		now.hits += loaded.hits;
+		now.misses += loaded.misses;
+		_hitsUpdates.fire_copy(tag);
+	}
+}
+
+QByteArray CacheAnalytics::serializeEntries() const {
+	const auto constant = sizeof(quint64) * 2 // key
+		+ sizeof(double) // priority
+		+ sizeof(qint64) // size
+		+ sizeof(qint32) // frequency
+		+ sizeof(quint8); // tag
+	auto result = QByteArray();
+	result.reserve(sizeof(qint32) * 2
+		+ sizeof(double)
+		+ _entries.size() * constant);
+
+	auto stream = QDataStream(&result, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_1);
+	stream
+		<< qint32(kSerializeVersion)
+		<< _inflation
+		<< qint32(_entries.size());
+	for (const auto &[key, entry] : _entries) {
+		stream
+			<< quint64(key.high)
+			<< quint64(key.low)
+			<< entry.priority
+			<< qint64(entry.size)
+			<< qint32(entry.frequency)
+			<< quint8(entry.tag);
+	}
+	stream.device()->close();
+	return result;
+}
+
+QByteArray CacheAnalytics::serializeHits() const {
+	auto result = QByteArray();
+	result.reserve(sizeof(qint32) * 2
+		+ _hits.size() * (sizeof(quint8) + sizeof(qint64) * 2));
+
+	auto stream = QDataStream(&result, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_1);
+	stream << qint32(kSerializeVersion) << qint32(_hits.size());
+	for (const auto &[tag, hits] : _hits) {
+		stream << quint8(tag) << qint64(hits.hits) << qint64(hits.misses);
+	}
+	stream.device()->close();
+	return result;
+}
+
+void CacheAnalytics::saveEntriesDelayed() {
+	if (!_saveEntriesTimer.isActive()) {
+		_saveEntriesTimer.callOnce(kSaveEntriesDelay);
+	}
+}
+
+void CacheAnalytics::saveHitsDelayed() {
+	if (!_saveHitsTimer.isActive()) {
+		_saveHitsTimer.callOnce(kSaveHitsDelay);
+	}
+}
+
+void CacheAnalytics::saveEntries() {
+	if (!_entriesLoaded) {
+		saveEntriesDelayed();
+		return;
+	}
+	_cache->put(Data::CacheAnalyticsKey(), serializeEntries());
+}
+
+void CacheAnalytics::saveHits() {
+	if (!_hitsLoaded) {
+		saveHitsDelayed();
+		return;
+	}
+	_cache->put(Data::CacheHitsKey(), serializeHits());
+}
+
+} // namespace Storage
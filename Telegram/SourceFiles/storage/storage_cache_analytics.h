@@ -0,0 +1,94 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "storage/cache/storage_cache_database.h"
+#include "base/weak_ptr.h"
+#include "base/timer.h"
+
+namespace Storage {
+
+struct CacheTagHits {
+	int64 hits = 0;
+	int64 misses = 0;
+};
+
+// Counts cache hits per cache tag and keeps a GDSF priority for the
+// entries read and written through the file loaders. The priority is
+// inflation + frequency * cost / size, where the cost is the price of
+// downloading the file again. When the database gets close to its size
+// limit the entries with the lowest priority are removed, so one-off
+// large files go first and often used stickers stay in the cache.
+class CacheAnalytics final : public base::has_weak_ptr {
+public:
+	CacheAnalytics(
+		not_null<Cache::Database*> cache,
+		Fn<int64()> sizeLimit);
+	~CacheAnalytics();
+
+	void stored(const Cache::Key &key, uint8 tag, int64 size);
+	void used(const Cache::Key &key, uint8 tag, int64 size);
+	void hit(const Cache::Key &key, uint8 tag, int64 size);
+	void missed(uint8 tag);
+
+	[[nodiscard]] CacheTagHits hits(uint8 tag) const;
+	[[nodiscard]] rpl::producer<CacheTagHits> hitsValue(uint8 tag) const;
+
+	// Keys removed by the eviction and tags cleared in the database.
+	[[nodiscard]] rpl::producer<Cache::Key> evicted() const;
+	[[nodiscard]] rpl::producer<uint8> tagCleared() const;
+
+private:
+	struct Entry {
+		double priority = 0.;
+		int64 size = 0;
+		int frequency = 0;
+		uint8 tag = 0;
+	};
+
+	void touch(const Cache::Key &key, uint8 tag, int64 size, int add);
+	void countHit(uint8 tag, bool hit);
+	void forgetCleared(const Cache::Database::Stats &stats);
+	void checkSize(int64 totalSize);
+	void evict(int64 totalSize, int64 limit);
+	void trimEntries();
+	[[nodiscard]] double computePriority(const Entry &entry) const;
+
+	void load();
+	void applyLoadedEntries(const QByteArray &serialized);
+	void applyLoadedHits(const QByteArray &serialized);
+	[[nodiscard]] QByteArray serializeEntries() const;
+	[[nodiscard]] QByteArray serializeHits() const;
+	void saveEntriesDelayed();
+	void saveHitsDelayed();
+	void saveEntries();
+	void saveHits();
+
+	const not_null<Cache::Database*> _cache;
+	const Fn<int64()> _sizeLimit;
+
+	base::flat_map<Cache::Key, Entry> _entries;
+	base::flat_map<uint8, CacheTagHits> _hits;
+	base::flat_map<uint8, int> _taggedCounts;
+	rpl::event_stream<uint8> _hitsUpdates;
+	rpl::event_stream<Cache::Key> _evicted;
+	rpl::event_stream<uint8> _tagCleared;
+	double _inflation = 0.;
+	crl::time _evictedAt = 0;
+	int64 _totalSize = 0;
+	bool _entriesLoaded = false;
+	bool _hitsLoaded = false;
+
+	base::Timer _recheckTimer;
+	base::Timer _saveEntriesTimer;
+	base::Timer _saveHitsTimer;
+	rpl::lifetime _lifetime;
+
+};
+
+} // namespace Storage
@@ -0,0 +1,303 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "storage/storage_cache_dedup.h"
+
+#include "storage/storage_cache_analytics.h"
+#include "data/data_types.h"
+#include "base/openssl_help.h"
+
+namespace Storage {
+namespace {
+
+// Smaller payloads take less space than the reference bookkeeping.
+constexpr auto kMinDedupSize = 4 * 1024;
+constexpr auto kSaveStatsDelay = 5 * crl::time(1000);
+
+constexpr auto kReferencePrefix = "content:";
+constexpr auto kReferencePrefixSize = 8;
+constexpr auto kReferenceSize = kReferencePrefixSize + 2 * int(sizeof(uint64));
+
+constexpr auto kStatsPrefix = "dedup:";
+constexpr auto kStatsPrefixSize = 6;
+
+// Stop counting new duplicates when that many payloads are tracked.
+constexpr auto kMaxSavedContents = 4096;
+
+struct SerializedContent {
+	uint64 high = 0;
+	uint64 low = 0;
+	int64 size = 0;
+	int32 references = 0;
+	int32 tag = 0;
+};
+
+[[nodiscard]] QByteArray SerializeReference(const Cache::Key &content) {
+	auto result = QByteArray(kReferencePrefix, kReferencePrefixSize);
+	result.append(
+		reinterpret_cast<const char*>(&content.high),
+		sizeof(content.high));
+	result.append(
+		reinterpret_cast<const char*>(&content.low),
+		sizeof(content.low));
+	return result;
+}
+
+[[nodiscard]] std::optional<Cache::Key> ParseReference(
+		const QByteArray &value) {
+	if (value.size() != kReferenceSize
+		|| !value.startsWith(kReferencePrefix)) {
+		return std::nullopt;
+	}
+	auto result = Cache::Key();
+	const auto data = value.constData() + kReferencePrefixSize;
+	memcpy(&result.high, data, sizeof(result.high));
+	memcpy(&result.low, data + sizeof(result.high), sizeof(result.low));
+	return result;
+}
+
+[[nodiscard]] std::vector<SerializedContent> ParseSaved(
+		const QByteArray &value) {
+	const auto size = value.size() - kStatsPrefixSize;
+	const auto count = size / int(sizeof(SerializedContent));
+	if (size < 0
+		|| size % sizeof(SerializedContent)
+		|| count > kMaxSavedContents
+		|| !value.startsWith(kStatsPrefix)) {
+		return {};
+	}
+	auto result = std::vector<SerializedContent>(count);
+	memcpy(result.data(), value.constData() + kStatsPrefixSize, size);
+	for (const auto &data : result) {
+		if (data.references <= 0
+			|| data.size < 0
+			|| data.tag < 0
+			|| data.tag > 255) {
+			return {};
+		}
+	}
+	return result;
+}
+
+} // namespace
+
+CacheDedup::CacheDedup(
+	not_null<Cache::Database*> cache,
+	not_null<CacheAnalytics*> analytics)
+: _cache(cache)
+, _analytics(analytics)
+, _saveStatsTimer([=] { saveStats(); }) {
+	loadStats();
+
+	_cache->statsOnMain(
+	) | rpl::filter([](const Cache::Database::Stats &stats) {
+		return stats.clearing;
+	}) | rpl::start_with_next([=] {
+		forgetAll();
+	}, _lifetime);
+
+	_analytics->evicted(
+	) | rpl::start_with_next([=](const Cache::Key &key) {
+		forget(key);
+	}, _lifetime);
+
+	_analytics->tagCleared(
+	) | rpl::start_with_next([=](uint8 tag) {
+		forgetTag(tag);
+	}, _lifetime);
+}
+
+void CacheDedup::put(
+		const Cache::Key &key,
+		Cache::Database::TaggedValue &&value) {
+	if (value.bytes.size() < kMinDedupSize
+		|| value.bytes.startsWith("partial:")) {
+		_analytics->stored(key, value.tag, value.bytes.size());
+		_cache->put(key, std::move(value));
+		return;
+	}
+	crl::async([=, weak = base::make_weak(this), value = std::move(value)](
+	) mutable {
+		const auto hash = openssl::Sha256(bytes::make_span(value.bytes));
+		const auto content = Data::ContentCacheKey(hash);
+		crl::on_main(weak, [=, value = std::move(value)]() mutable {
+			store(key, content, std::move(value));
+		});
+	});
+}
+
+void CacheDedup::store(
+		const Cache::Key &key,
+		const Cache::Key &content,
+		Cache::Database::TaggedValue &&value) {
+	// Only the size of the content entry is read, not its bytes.
+	auto done = [=, weak = base::make_weak(this), value = std::move(value)](
+			QByteArray &&existing,
+			std::vector<int> &&sizes) mutable {
+		const auto referenced = (ParseReference(existing) == content);
+		const auto exists = !sizes.empty() && (sizes.front() > 0);
+		crl::on_main(weak, [=, value = std::move(value)]() mutable {
+			stored(key, content, std::move(value), referenced, exists);
+		});
+	};
+	_cache->getWithSizes(key, { content }, std::move(done));
+}
+
+void CacheDedup::stored(
+		const Cache::Key &key,
+		const Cache::Key &content,
+		Cache::Database::TaggedValue &&value,
+		bool referenced,
+		bool exists) {
+	const auto size = int64(value.bytes.size());
+	if (!exists) {
+		_analytics->stored(content, value.tag, size);
+		_cache->put(content, std::move(value));
+	} else {
+		_analytics->used(content, value.tag, size);
+	}
+	if (referenced) {
+		return;
+	} else if (exists
+		&& (_saved.size() < kMaxSavedContents || _saved.contains(content))) {
+		auto &saved = _saved[content];
+		++saved.references;
+		saved.size = size;
+		saved.tag = value.tag;
+		statsChanged();
+	}
+	// References are left untagged, so the per-type counts in
+	// the storage settings show every payload only once.
+	_cache->put(key, SerializeReference(content));
+}
+
+void CacheDedup::get(
+		const Cache::Key &key,
+		uint8 tag,
+		FnMut<void(QByteArray&&)> &&done) {
+	const auto weak = base::make_weak(this);
+	auto resolve = [=, done = std::move(done)](QByteArray &&value) mutable {
+		const auto content = ParseReference(value);
+		if (!content) {
+			crl::on_main(weak, [=] { got(key, tag, value); });
+			done(std::move(value));
+			return;
+		}
+		// A reference to an evicted payload is read as a cache miss.
+		crl::on_main(weak, [=, done = std::move(done)]() mutable {
+			_cache->get(*content, [=, done = std::move(done)](
+					QByteArray &&value) mutable {
+				crl::on_main(weak, [=] {
+					got(*content, tag, value);
+					if (value.isEmpty()) {
+						forget(*content);
+					}
+				});
+				done(std::move(value));
+			});
+		});
+	};
+	_cache->get(key, std::move(resolve));
+}
+
+void CacheDedup::got(
+		const Cache::Key &key,
+		uint8 tag,
+		const QByteArray &value) {
+	// A partially downloaded file still has to be loaded from the network.
+	if (!value.isEmpty() && !value.startsWith("partial:")) {
+		_analytics->hit(key, tag, value.size());
+	} else {
+		_analytics->missed(tag);
+	}
+}
+
+rpl::producer<CacheDedupStats> CacheDedup::statsValue() const {
+	return _stats.value();
+}
+
+void CacheDedup::forget(const Cache::Key &content) {
+	if (_saved.remove(content)) {
+		statsChanged();
+	}
+}
+
+void CacheDedup::forgetTag(uint8 tag) {
+	const auto was = _saved.size();
+	for (auto i = begin(_saved); i != end(_saved);) {
+		if (i->second.tag == tag) {
+			i = _saved.erase(i);
+		} else {
+			++i;
+		}
+	}
+	if (_saved.size() != was) {
+		statsChanged();
+	}
+}
+
+void CacheDedup::forgetAll() {
+	if (!_saved.empty()) {
+		_saved.clear();
+		statsChanged();
+	}
+}
+
+void CacheDedup::statsChanged() {
+	refreshStats();
+	if (!_saveStatsTimer.isActive()) {
+		_saveStatsTimer.callOnce(kSaveStatsDelay);
+	}
+}
+
+void CacheDedup::refreshStats() {
+	auto stats = CacheDedupStats();
+	for (const auto &[content, saved] : _saved) {
+		stats.count += saved.references;
+		stats.savedSize += saved.references * saved.size;
+	}
+	_stats = stats;
+}
+
+void CacheDedup::loadStats() {
+	auto done = [=, weak = base::make_weak(this)](QByteArray &&value) {
+		crl::on_main(weak, [=, value = std::move(value)] {
+			_statsLoaded = true;
+			for (const auto &data : ParseSaved(value)) {
+				auto &saved = _saved[Cache::Key{ data.high, data.low }];
+				saved.references += data.references;
+				saved.size = data.size;
+				saved.tag = uint8(data.tag);
+			}
+			refreshStats();
+		});
+	};
+	_cache->get(Data::ContentCacheStatsKey(), std::move(done));
+}
+
+void CacheDedup::saveStats() {
+	if (!_statsLoaded) {
+		_saveStatsTimer.callOnce(kSaveStatsDelay);
+		return;
+	}
+	auto result = QByteArray(kStatsPrefix, kStatsPrefixSize);
+	result.reserve(kStatsPrefixSize
+		+ _saved.size() * sizeof(SerializedContent));
+	for (const auto &[content, saved] : _saved) {
+		const auto data = SerializedContent{
+			.high = content.high,
+			.low = content.low,
+			.size = saved.size,
+			.references = saved.references,
+			.tag = saved.tag,
+		};
+		result.append(reinterpret_cast<const char*>(&data), sizeof(data));
+	}
+	_cache->put(Data::ContentCacheStatsKey(), std::move(result));
+}
+
+} // namespace Storage
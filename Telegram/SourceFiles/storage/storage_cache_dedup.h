@@ -0,0 +1,87 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "storage/cache/storage_cache_database.h"
+#include "base/weak_ptr.h"
+#include "base/timer.h"
+
+namespace Storage {
+
+class CacheAnalytics;
+
+struct CacheDedupStats {
+	int count = 0;
+	int64 savedSize = 0;
+
+	inline bool operator==(const CacheDedupStats &other) const {
+		return (count == other.count) && (savedSize == other.savedSize);
+	}
+	inline bool operator!=(const CacheDedupStats &other) const {
+		return !(*this == other);
+	}
+};
+
+// Downloaded payloads are stored once under a key made from their
+// SHA-256 and every file key gets a small reference record instead,
+// so forwarded copies and re-uploads share one cache entry.
+class CacheDedup final : public base::has_weak_ptr {
+public:
+	CacheDedup(
+		not_null<Cache::Database*> cache,
+		not_null<CacheAnalytics*> analytics);
+
+	void put(const Cache::Key &key, Cache::Database::TaggedValue &&value);
+	void get(
+		const Cache::Key &key,
+		uint8 tag,
+		FnMut<void(QByteArray&&)> &&done);
+
+	[[nodiscard]] rpl::producer<CacheDedupStats> statsValue() const;
+
+private:
+	void store(
+		const Cache::Key &key,
+		const Cache::Key &content,
+		Cache::Database::TaggedValue &&value);
+	void stored(
+		const Cache::Key &key,
+		const Cache::Key &content,
+		Cache::Database::TaggedValue &&value,
+		bool referenced,
+		bool exists);
+	struct SavedContent {
+		int references = 0;
+		int64 size = 0;
+		uint8 tag = 0;
+	};
+
+	void got(const Cache::Key &key, uint8 tag, const QByteArray &value);
+	void forget(const Cache::Key &content);
+	void forgetTag(uint8 tag);
+	void forgetAll();
+	void statsChanged();
+	void refreshStats();
+	void loadStats();
+	void saveStats();
+
+	const not_null<Cache::Database*> _cache;
+	const not_null<CacheAnalytics*> _analytics;
+
+	// Payloads that were stored once for several keys, the stats count
+	// only the ones that are still in the database.
+	base::flat_map<Cache::Key, SavedContent> _saved;
+	rpl::variable<CacheDedupStats> _stats;
+	base::Timer _saveStatsTimer;
+	bool _statsLoaded = false;
+
+	rpl::lifetime _lifetime;
+
+};
+
+} // namespace Storage
@@ -7,11 +7,13 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "storage/storage_domain.h"
 
+#include "storage/storage_account.h"
 #include "storage/details/storage_file_utilities.h"
 #include "storage/serialize_common.h"
 #include "mtproto/mtproto_config.h"
 #include "main/main_domain.h"
 #include "main/main_account.h"
+#include "core/core_trace.h"
 #include "base/random.h"
 
 namespace Storage {
@@ -39,6 +41,7 @@ Domain::Domain(not_null<Main::Domain*> owner, const QString &dataName)
 Domain::~Domain() = default;
 
 StartResult Domain::start(const QByteArray &passcode) {
+	TRACE_ZONE("Storage::Domain::start");
 	const auto modern = startModern(passcode);
 	if (modern == StartModernResult::Success) {
 		if (_oldVersion < AppVersion) {
@@ -116,6 +119,7 @@ void Domain::encryptLocalKey(const QByteArray &passcode) {
 Domain::StartModernResult Domain::startModern(
 		const QByteArray &passcode) {
 	const auto name = ComputeKeyName(_dataName);
+	const auto started = crl::now();
 
 	FileReadDescriptor keyData;
 	if (!ReadFile(keyData, name, BaseGlobalPath())) {
@@ -166,44 +170,87 @@ Domain::StartModernResult Domain::startModern(
 	}
 
 	_oldVersion = keyData.version;
-
+	LOG(("App Info: accounts info read in %1 ms.").arg(crl::now() - started));
+
+	struct Pending {
+		std::unique_ptr<Main::Account> account;
+		int index = 0;
+		bool last = false;
+	};
+	auto pending = std::vector<Pending>();
 	auto tried = base::flat_set<int>();
-	auto sessions = base::flat_set<uint64>();
-	auto active = 0;
 	for (auto i = 0; i != count; ++i) {
 		auto index = qint32();
 		info.stream >> index;
 		if (index >= 0
 			&& index < Main::Domain::kPremiumMaxAccounts
 			&& tried.emplace(index).second) {
-			auto account = std::make_unique<Main::Account>(
-				_owner,
-				_dataName,
-				index);
-			auto config = account->prepareToStart(_localKey);
-			const auto sessionId = account->willHaveSessionUniqueId(
-				config.get());
-			if (!sessions.contains(sessionId)
-				&& (sessionId != 0 || (sessions.empty() && i + 1 == count))) {
-				if (sessions.empty()) {
-					active = index;
-				}
-				account->start(std::move(config));
-				_owner->accountAddedInStorage({
-					.index = index,
-					.account = std::move(account)
-				});
-				sessions.emplace(sessionId);
+			pending.push_back({
+				.account = std::make_unique<Main::Account>(
+					_owner,
+					_dataName,
+					index),
+				.index = index,
+				.last = (i + 1 == count),
+			});
+		}
+	}
+	auto stored = std::optional<qint32>();
+	if (!info.stream.atEnd()) {
+		info.stream >> stored.emplace();
+	}
+
+	// Read and decrypt the files of all accounts on worker threads,
+	// the stored active account first, then start them one by one.
+	if (pending.size() > 1) {
+		const auto first = stored
+			? ranges::find(pending, *stored, &Pending::index)
+			: end(pending);
+		if (first != end(pending)) {
+			first->account->local().preload(_localKey);
+		}
+		for (auto i = begin(pending); i != end(pending); ++i) {
+			if (i != first) {
+				i->account->local().preload(_localKey);
 			}
 		}
 	}
+
+	auto sessions = base::flat_set<uint64>();
+	auto active = 0;
+	for (auto &[account, index, last] : pending) {
+		const auto accountStarted = crl::now();
+		auto config = account->prepareToStart(_localKey);
+		const auto read = crl::now();
+		const auto sessionId = account->willHaveSessionUniqueId(
+			config.get());
+		if (!sessions.contains(sessionId)
+			&& (sessionId != 0 || (sessions.empty() && last))) {
+			if (sessions.empty()) {
+				active = index;
+			}
+			account->start(std::move(config));
+			LOG(("App Info: account %1 read in %2 ms, started in %3 ms."
+				).arg(index
+				).arg(read - accountStarted
+				).arg(crl::now() - read));
+			_owner->accountAddedInStorage({
+				.index = index,
+				.account = std::move(account)
+			});
+			sessions.emplace(sessionId);
+		}
+	}
+	ClearPreloaded();
+	LOG(("App Info: accounts started in %1 ms.").arg(crl::now() - started));
+
 	if (sessions.empty()) {
 		LOG(("App Error: no accounts read."));
 		return StartModernResult::Failed;
 	}
 
-	if (!info.stream.atEnd()) {
-		info.stream >> active;
+	if (stored) {
+		active = *stored;
 	}
 	_owner->activateFromStorage(active);
 
@@ -20,6 +20,10 @@ public:
 	void remove(SharedMediaRemoveOne &&query);
 	void remove(SharedMediaRemoveAll &&query);
 	void invalidate(SharedMediaInvalidateBottom &&query);
+	void restoreSharedMediaCount(
+		PeerId peerId,
+		SharedMediaType type,
+		int count);
 	rpl::producer<SharedMediaResult> query(SharedMediaQuery &&query) const;
 	SharedMediaResult snapshot(const SharedMediaQuery &query) const;
 	bool empty(const SharedMediaKey &key) const;
@@ -27,6 +31,7 @@ public:
 	rpl::producer<SharedMediaRemoveOne> sharedMediaOneRemoved() const;
 	rpl::producer<SharedMediaRemoveAll> sharedMediaAllRemoved() const;
 	rpl::producer<SharedMediaInvalidateBottom> sharedMediaBottomInvalidated() const;
+	rpl::producer<SharedMediaCountUpdate> sharedMediaCountUpdated() const;
 
 	void add(UserPhotosAddNew &&query);
 	void add(UserPhotosAddSlice &&query);
@@ -65,6 +70,13 @@ void Facade::Impl::invalidate(SharedMediaInvalidateBottom &&query) {
 	_sharedMedia.invalidate(std::move(query));
 }
 
+void Facade::Impl::restoreSharedMediaCount(
+		PeerId peerId,
+		SharedMediaType type,
+		int count) {
+	_sharedMedia.restoreCount(peerId, type, count);
+}
+
 rpl::producer<SharedMediaResult> Facade::Impl::query(SharedMediaQuery &&query) const {
 	return _sharedMedia.query(std::move(query));
 }
@@ -93,6 +105,10 @@ rpl::producer<SharedMediaInvalidateBottom> Facade::Impl::sharedMediaBottomInvali
 	return _sharedMedia.bottomInvalidated();
 }
 
+rpl::producer<SharedMediaCountUpdate> Facade::Impl::sharedMediaCountUpdated() const {
+	return _sharedMedia.countUpdated();
+}
+
 void Facade::Impl::add(UserPhotosAddNew &&query) {
 	return _userPhotos.add(std::move(query));
 }
@@ -144,6 +160,13 @@ void Facade::invalidate(SharedMediaInvalidateBottom &&query) {
 	_impl->invalidate(std::move(query));
 }
 
+void Facade::restoreSharedMediaCount(
+		PeerId peerId,
+		SharedMediaType type,
+		int count) {
+	_impl->restoreSharedMediaCount(peerId, type, count);
+}
+
 rpl::producer<SharedMediaResult> Facade::query(SharedMediaQuery &&query) const {
 	return _impl->query(std::move(query));
 }
@@ -172,6 +195,10 @@ rpl::producer<SharedMediaInvalidateBottom> Facade::sharedMediaBottomInvalidated(
 	return _impl->sharedMediaBottomInvalidated();
 }
 
+rpl::producer<SharedMediaCountUpdate> Facade::sharedMediaCountUpdated() const {
+	return _impl->sharedMediaCountUpdated();
+}
+
 void Facade::add(UserPhotosAddNew &&query) {
 	return _impl->add(std::move(query));
 }
@@ -28,6 +28,8 @@ struct SharedMediaQuery;
 struct SharedMediaKey;
 using SharedMediaResult = SparseIdsListResult;
 struct SharedMediaSliceUpdate;
+struct SharedMediaCountUpdate;
+enum class SharedMediaType : signed char;
 
 struct UserPhotosAddNew;
 struct UserPhotosAddSlice;
@@ -47,6 +49,10 @@ public:
 	void remove(SharedMediaRemoveOne &&query);
 	void remove(SharedMediaRemoveAll &&query);
 	void invalidate(SharedMediaInvalidateBottom &&query);
+	void restoreSharedMediaCount(
+		PeerId peerId,
+		SharedMediaType type,
+		int count);
 
 	rpl::producer<SharedMediaResult> query(SharedMediaQuery &&query) const;
 	SharedMediaResult snapshot(const SharedMediaQuery &query) const;
@@ -55,6 +61,7 @@ public:
 	rpl::producer<SharedMediaRemoveOne> sharedMediaOneRemoved() const;
 	rpl::producer<SharedMediaRemoveAll> sharedMediaAllRemoved() const;
 	rpl::producer<SharedMediaInvalidateBottom> sharedMediaBottomInvalidated() const;
+	rpl::producer<SharedMediaCountUpdate> sharedMediaCountUpdated() const;
 
 	void add(UserPhotosAddNew &&query);
 	void add(UserPhotosAddSlice &&query);
@@ -33,13 +33,26 @@ std::map<PeerId, SharedMedia::Lists>::iterator
 	return result;
 }
 
+void SharedMedia::checkCountUpdated(
+		PeerId peer,
+		SharedMediaType type,
+		std::optional<int> was,
+		std::optional<int> now) {
+	if (was != now) {
+		_countUpdated.fire({ .peerId = peer, .type = type, .count = now });
+	}
+}
+
 void SharedMedia::add(SharedMediaAddNew &&query) {
 	auto peer = query.peerId;
 	auto peerIt = enforceLists(peer);
 	for (auto index = 0; index != kSharedMediaTypeCount; ++index) {
 		auto type = static_cast<SharedMediaType>(index);
 		if (query.types.test(type)) {
-			peerIt->second[index].addNew(query.messageId);
+			auto &list = peerIt->second[index];
+			const auto was = list.count();
+			list.addNew(query.messageId);
+			checkCountUpdated(peer, type, was, list.count());
 		}
 	}
 }
@@ -59,10 +72,13 @@ void SharedMedia::add(SharedMediaAddSlice &&query) {
 
 	auto peerIt = enforceLists(query.peerId);
 	auto index = static_cast<int>(query.type);
-	peerIt->second[index].addSlice(
+	auto &list = peerIt->second[index];
+	const auto was = list.count();
+	list.addSlice(
 		std::move(query.messageIds),
 		query.noSkipRange,
 		query.count);
+	checkCountUpdated(query.peerId, query.type, was, list.count());
 }
 
 void SharedMedia::remove(SharedMediaRemoveOne &&query) {
@@ -71,7 +87,10 @@ void SharedMedia::remove(SharedMediaRemoveOne &&query) {
 		for (auto index = 0; index != kSharedMediaTypeCount; ++index) {
 			auto type = static_cast<SharedMediaType>(index);
 			if (query.types.test(type)) {
-				peerIt->second[index].removeOne(query.messageId);
+				auto &list = peerIt->second[index];
+				const auto was = list.count();
+				list.removeOne(query.messageId);
+				checkCountUpdated(query.peerId, type, was, list.count());
 			}
 		}
 		_oneRemoved.fire(std::move(query));
@@ -84,7 +103,10 @@ void SharedMedia::remove(SharedMediaRemoveAll &&query) {
 		for (auto index = 0; index != kSharedMediaTypeCount; ++index) {
 			auto type = static_cast<SharedMediaType>(index);
 			if (query.types.test(type)) {
-				peerIt->second[index].removeAll();
+				auto &list = peerIt->second[index];
+				const auto was = list.count();
+				list.removeAll();
+				checkCountUpdated(query.peerId, type, was, list.count());
 			}
 		}
 		_allRemoved.fire(std::move(query));
@@ -95,12 +117,26 @@ void SharedMedia::invalidate(SharedMediaInvalidateBottom &&query) {
 	auto peerIt = _lists.find(query.peerId);
 	if (peerIt != _lists.end()) {
 		for (auto index = 0; index != kSharedMediaTypeCount; ++index) {
-			peerIt->second[index].invalidateBottom();
+			auto type = static_cast<SharedMediaType>(index);
+			auto &list = peerIt->second[index];
+			const auto was = list.count();
+			list.invalidateBottom();
+			checkCountUpdated(query.peerId, type, was, list.count());
 		}
 		_bottomInvalidated.fire(std::move(query));
 	}
 }
 
+void SharedMedia::restoreCount(
+		PeerId peerId,
+		SharedMediaType type,
+		int count) {
+	Expects(IsValidSharedMediaType(type));
+
+	auto peerIt = enforceLists(peerId);
+	peerIt->second[static_cast<int>(type)].restoreCount(count);
+}
+
 rpl::producer<SharedMediaResult> SharedMedia::query(SharedMediaQuery &&query) const {
 	Expects(IsValidSharedMediaType(query.key.type));
 
@@ -159,4 +195,8 @@ rpl::producer<SharedMediaInvalidateBottom> SharedMedia::bottomInvalidated() cons
 	return _bottomInvalidated.events();
 }
 
+rpl::producer<SharedMediaCountUpdate> SharedMedia::countUpdated() const {
+	return _countUpdated.events();
+}
+
 } // namespace Storage
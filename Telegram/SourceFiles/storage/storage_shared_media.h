@@ -185,6 +185,12 @@ struct SharedMediaSliceUpdate {
 	SparseIdsSliceUpdate data;
 };
 
+struct SharedMediaCountUpdate {
+	PeerId peerId = 0;
+	SharedMediaType type = SharedMediaType::kCount;
+	std::optional<int> count;
+};
+
 class SharedMedia {
 public:
 	using Type = SharedMediaType;
@@ -195,6 +201,7 @@ public:
 	void remove(SharedMediaRemoveOne &&query);
 	void remove(SharedMediaRemoveAll &&query);
 	void invalidate(SharedMediaInvalidateBottom &&query);
+	void restoreCount(PeerId peerId, SharedMediaType type, int count);
 
 	rpl::producer<SharedMediaResult> query(SharedMediaQuery &&query) const;
 	SharedMediaResult snapshot(const SharedMediaQuery &query) const;
@@ -203,11 +210,17 @@ public:
 	rpl::producer<SharedMediaRemoveOne> oneRemoved() const;
 	rpl::producer<SharedMediaRemoveAll> allRemoved() const;
 	rpl::producer<SharedMediaInvalidateBottom> bottomInvalidated() const;
+	rpl::producer<SharedMediaCountUpdate> countUpdated() const;
 
 private:
 	using Lists = std::array<SparseIdsList, kSharedMediaTypeCount>;
 
 	std::map<PeerId, Lists>::iterator enforceLists(PeerId peer);
+	void checkCountUpdated(
+		PeerId peer,
+		SharedMediaType type,
+		std::optional<int> was,
+		std::optional<int> now);
 
 	std::map<PeerId, Lists> _lists;
 
@@ -215,6 +228,7 @@ private:
 	rpl::event_stream<SharedMediaRemoveOne> _oneRemoved;
 	rpl::event_stream<SharedMediaRemoveAll> _allRemoved;
 	rpl::event_stream<SharedMediaInvalidateBottom> _bottomInvalidated;
+	rpl::event_stream<SharedMediaCountUpdate> _countUpdated;
 
 	rpl::lifetime _lifetime;
 
@@ -111,6 +111,8 @@ void SparseIdsList::addRange(
 		_count = count;
 	} else if (incrementCount && _count && result.added > 0) {
 		*_count += result.added;
+	} else if (incrementCount && _restoredCount && result.added > 0) {
+		*_restoredCount += result.added;
 	}
 	if (_slices.size() == 1) {
 		if (_count && _slices.front().messages.size() >= *_count) {
@@ -125,6 +127,9 @@ void SparseIdsList::addRange(
 	if (_count && update.messages) {
 		accumulate_max(*_count, int(update.messages->size()));
 	}
+	if (_count) {
+		_restoredCount = std::nullopt;
+	}
 	update.count = _count;
 	_sliceUpdated.fire(std::move(update));
 }
@@ -161,6 +166,8 @@ void SparseIdsList::removeOne(MsgId messageId) {
 	}
 	if (_count) {
 		--*_count;
+	} else if (_restoredCount && *_restoredCount > 0) {
+		--*_restoredCount;
 	}
 }
 
@@ -168,6 +175,7 @@ void SparseIdsList::removeAll() {
 	_slices.clear();
 	_slices.emplace(base::flat_set<MsgId>{}, MsgRange { 0, ServerMaxMsgId });
 	_count = 0;
+	_restoredCount = std::nullopt;
 }
 
 void SparseIdsList::invalidateBottom() {
@@ -182,6 +190,17 @@ void SparseIdsList::invalidateBottom() {
 		}
 	}
 	_count = std::nullopt;
+	_restoredCount = std::nullopt;
+}
+
+void SparseIdsList::restoreCount(int count) {
+	if (!_count) {
+		_restoredCount = count;
+	}
+}
+
+std::optional<int> SparseIdsList::displayCount() const {
+	return _count ? _count : _restoredCount;
 }
 
 rpl::producer<SparseIdsListResult> SparseIdsList::query(
@@ -197,9 +216,9 @@ rpl::producer<SparseIdsListResult> SparseIdsList::query(
 		if (slice != _slices.end()
 			&& slice->range.from <= query.aroundId) {
 			consumer.put_next(queryFromSlice(query, *slice));
-		} else if (_count) {
+		} else if (const auto count = displayCount()) {
 			auto result = SparseIdsListResult {};
-			result.count = _count;
+			result.count = count;
 			consumer.put_next(std::move(result));
 		}
 		consumer.put_done();
@@ -219,9 +238,9 @@ SparseIdsListResult SparseIdsList::snapshot(
 	if (slice != _slices.end()
 		&& slice->range.from <= query.aroundId) {
 		return queryFromSlice(query, *slice);
-	} else if (_count) {
+	} else if (const auto count = displayCount()) {
 		auto result = SparseIdsListResult{};
-		result.count = _count;
+		result.count = count;
 		return result;
 	}
 	return {};
@@ -236,6 +255,10 @@ bool SparseIdsList::empty() const {
 	return true;
 }
 
+std::optional<int> SparseIdsList::count() const {
+	return _count;
+}
+
 rpl::producer<SparseIdsSliceUpdate> SparseIdsList::sliceUpdated() const {
 	return _sliceUpdated.events();
 }
@@ -49,10 +49,12 @@ public:
 	void removeOne(MsgId messageId);
 	void removeAll();
 	void invalidateBottom();
+	void restoreCount(int count);
 	rpl::producer<SparseIdsListResult> query(SparseIdsListQuery &&query) const;
 	rpl::producer<SparseIdsSliceUpdate> sliceUpdated() const;
 	SparseIdsListResult snapshot(const SparseIdsListQuery &query) const;
 	bool empty() const;
+	std::optional<int> count() const;
 
 private:
 	struct Slice {
@@ -95,8 +97,13 @@ private:
 	SparseIdsListResult queryFromSlice(
 		const SparseIdsListQuery &query,
 		const Slice &slice) const;
+	[[nodiscard]] std::optional<int> displayCount() const;
 
 	std::optional<int> _count;
+
+	// Restored from the local storage, may be stale. It is only shown
+	// until the real count is known, never used to complete the slices.
+	std::optional<int> _restoredCount;
 	base::flat_set<Slice> _slices;
 
 	rpl::event_stream<SparseIdsSliceUpdate> _sliceUpdated;
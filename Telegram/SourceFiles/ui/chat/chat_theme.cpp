@@ -25,6 +25,7 @@ constexpr auto kCacheBackgroundTimeout = 1 * crl::time(1000);
 constexpr auto kCacheBackgroundFastTimeout = crl::time(200);
 constexpr auto kBackgroundFadeDuration = crl::time(200);
 constexpr auto kMinimumTiledSize = 512;
+constexpr auto kRecentBackgroundsLimit = 3;
 constexpr auto kMaxSize = 2960;
 constexpr auto kMaxContrastValue = 21.;
 constexpr auto kMinAcceptableContrast = 1.14;// 4.5;
@@ -398,6 +399,7 @@ void ChatTheme::setBackground(ChatThemeBackground &&background) {
 	_mutableBackground = std::move(background);
 	_backgroundState = {};
 	_backgroundNext = {};
+	_recentBackgrounds.clear();
 	_backgroundFade.stop();
 	if (_cacheBackgroundTimer) {
 		_cacheBackgroundTimer->cancel();
@@ -409,6 +411,7 @@ void ChatTheme::updateBackgroundImageFrom(ChatThemeBackground &&background) {
 	_mutableBackground.prepared = std::move(background.prepared);
 	_mutableBackground.preparedForTiled = std::move(
 		background.preparedForTiled);
+	_recentBackgrounds.clear();
 	if (!_backgroundState.now.pixmap.isNull()) {
 		if (_cacheBackgroundTimer) {
 			_cacheBackgroundTimer->cancel();
@@ -434,18 +437,17 @@ void ChatTheme::setBubblesBackground(QImage image) {
 		//_repaintBackgroundRequests.fire({});
 		return;
 	}
-	_bubblesBackground = CacheBackground({
-		.background = {
-			.prepared = _bubblesBackgroundPrepared,
-		},
-		.area = (_bubblesBackground.area.isEmpty()
-			? _bubblesBackgroundPrepared.size()
-			: _bubblesBackground.area),
-	});
 	if (!_bubblesBackgroundPattern) {
 		_bubblesBackgroundPattern = PrepareBubblePattern(palette());
 	}
-	_bubblesBackgroundPattern->pixmap = _bubblesBackground.pixmap;
+
+	// The gradient is sampled for any area when bubbles are painted.
+	_bubblesBackgroundPattern->pixmap = CachedBackground(CacheBackground({
+		.background = {
+			.prepared = _bubblesBackgroundPrepared,
+		},
+		.area = _bubblesBackgroundPrepared.size(),
+	})).pixmap;
 	// setBubblesBackground called only from background thread.
 	//_repaintBackgroundRequests.fire({});
 }
@@ -461,21 +463,7 @@ ChatPaintContext ChatTheme::preparePaintContext(
 		QRect viewport,
 		QRect clip,
 		bool paused) {
-	const auto area = viewport.size();
 	const auto now = crl::now();
-	if (!_bubblesBackgroundPrepared.isNull()
-		&& _bubblesBackground.area != area) {
-		if (!_cacheBubblesTimer) {
-			_cacheBubblesTimer.emplace([=] { cacheBubbles(); });
-		}
-		if (_cacheBubblesArea != area
-			|| (!_cacheBubblesTimer->isActive()
-				&& !_bubblesCachingRequest)) {
-			_cacheBubblesArea = area;
-			_lastBubblesAreaChangeTime = now;
-			_cacheBubblesTimer->callOnce(kCacheBackgroundFastTimeout);
-		}
-	}
 	return {
 		.st = st,
 		.bubblesPattern = _bubblesBackgroundPattern.get(),
@@ -499,7 +487,10 @@ const BackgroundState &ChatTheme::backgroundState(QSize area) {
 		setCachedBackground(CacheBackground(cacheBackgroundRequest(area)));
 		_cacheBackgroundTimer->cancel();
 	} else if (_backgroundState.now.area != area) {
-		if (_cacheBackgroundArea != area
+		if (restoreCachedBackground(area)) {
+			_cacheBackgroundArea = area;
+			_cacheBackgroundTimer->cancel();
+		} else if (_cacheBackgroundArea != area
 			|| (!_cacheBackgroundTimer->isActive()
 				&& !_backgroundCachingRequest)) {
 			_cacheBackgroundArea = area;
@@ -603,6 +594,10 @@ void ChatTheme::cacheBackgroundAsync(
 		crl::on_main(weak, [=, result = CacheBackground(request)]() mutable {
 			if (done) {
 				done(std::move(result));
+			} else if (request.area != _cacheBackgroundArea
+				&& _backgroundState.now.area == _cacheBackgroundArea) {
+				// Restored from the recent backgrounds meanwhile.
+				_backgroundCachingRequest = {};
 			} else if (const auto request = cacheBackgroundRequest(
 					_cacheBackgroundArea)) {
 				if (_backgroundCachingRequest != request) {
@@ -619,17 +614,21 @@ void ChatTheme::cacheBackgroundAsync(
 void ChatTheme::setCachedBackground(CacheBackgroundResult &&cached) {
 	_backgroundNext = {};
 
+	const auto gradient = cached.gradient;
+	auto result = CachedBackground(std::move(cached));
+	rememberCachedBackground(result, gradient);
+
 	if (background().gradientForFill.isNull()
 		|| _backgroundState.now.pixmap.isNull()
 		|| anim::Disabled()) {
 		_backgroundFade.stop();
 		_backgroundState.shown = 1.;
-		_backgroundState.now = std::move(cached);
+		_backgroundState.now = std::move(result);
 		return;
 	}
 	// #TODO themes compose several transitions.
 	_backgroundState.was = std::move(_backgroundState.now);
-	_backgroundState.now = std::move(cached);
+	_backgroundState.now = std::move(result);
 	_backgroundState.shown = 0.;
 	const auto callback = [=] {
 		if (!_backgroundFade.animating()) {
@@ -645,62 +644,41 @@ void ChatTheme::setCachedBackground(CacheBackgroundResult &&cached) {
 		kBackgroundFadeDuration);
 }
 
-auto ChatTheme::cacheBubblesRequest(QSize area) const
--> CacheBackgroundRequest {
-	if (_bubblesBackgroundPrepared.isNull()) {
-		return {};
-	}
-	return {
-		.background = {
-			.gradientForFill = _bubblesBackgroundPrepared,
-		},
-		.area = area,
-	};
-}
-
-void ChatTheme::cacheBubbles() {
-	Expects(_cacheBubblesTimer.has_value());
-
-	const auto now = crl::now();
-	if (now - _lastBubblesAreaChangeTime < kCacheBackgroundTimeout
-		&& QGuiApplication::mouseButtons() != 0) {
-		_cacheBubblesTimer->callOnce(kCacheBackgroundFastTimeout);
+void ChatTheme::rememberCachedBackground(
+		const CachedBackground &cached,
+		const QImage &gradient) {
+	if (cached.pixmap.isNull() || cached.area.isEmpty()) {
 		return;
 	}
-	cacheBubblesNow();
-}
-
-void ChatTheme::cacheBubblesNow() {
-	if (!_bubblesCachingRequest) {
-		if (const auto request = cacheBackgroundRequest(
-				_cacheBubblesArea)) {
-			cacheBubblesAsync(request);
-		}
+	const auto gradientKey = gradient.cacheKey();
+	const auto i = ranges::find_if(_recentBackgrounds, [&](
+			const RecentBackground &recent) {
+		return (recent.cached.area == cached.area)
+			&& (recent.gradientKey == gradientKey);
+	});
+	if (i != end(_recentBackgrounds)) {
+		_recentBackgrounds.erase(i);
+	} else if (_recentBackgrounds.size() == kRecentBackgroundsLimit) {
+		_recentBackgrounds.erase(begin(_recentBackgrounds));
 	}
+	_recentBackgrounds.push_back({ cached, gradientKey });
 }
 
-void ChatTheme::cacheBubblesAsync(
-		const CacheBackgroundRequest &request) {
-	_bubblesCachingRequest = request;
-	const auto weak = base::make_weak(this);
-	crl::async([=] {
-		if (!weak) {
-			return;
-		}
-		crl::on_main(weak, [=, result = CacheBackground(request)]() mutable {
-			if (const auto request = cacheBubblesRequest(
-					_cacheBubblesArea)) {
-				if (_bubblesCachingRequest != request) {
-					cacheBubblesAsync(request);
-				} else {
-					_bubblesCachingRequest = {};
-					_bubblesBackground = std::move(result);
-					_bubblesBackgroundPattern->pixmap
-						= _bubblesBackground.pixmap;
-				}
-			}
-		});
+bool ChatTheme::restoreCachedBackground(QSize area) {
+	const auto gradientKey = background().gradientForFill.cacheKey();
+	const auto i = ranges::find_if(_recentBackgrounds, [&](
+			const RecentBackground &recent) {
+		return (recent.cached.area == area)
+			&& (recent.gradientKey == gradientKey);
 	});
+	if (i == end(_recentBackgrounds)) {
+		return false;
+	}
+	_backgroundFade.stop();
+	_backgroundState.was = {};
+	_backgroundState.shown = 1.;
+	_backgroundState.now = i->cached;
+	return true;
 }
 
 rpl::producer<> ChatTheme::repaintBackgroundRequests() const {
@@ -711,8 +689,7 @@ void ChatTheme::rotateComplexGradientBackground() {
 	if (!_backgroundFade.animating() && !_backgroundNext.image.isNull()) {
 		if (_mutableBackground.gradientForFill.size()
 			== _backgroundNext.gradient.size()) {
-			_mutableBackground.gradientForFill
-				= std::move(_backgroundNext.gradient);
+			_mutableBackground.gradientForFill = _backgroundNext.gradient;
 		}
 		setCachedBackground(base::take(_backgroundNext));
 	}
@@ -189,16 +189,13 @@ private:
 		const CacheBackgroundRequest &request,
 		Fn<void(CacheBackgroundResult&&)> done = nullptr);
 	void setCachedBackground(CacheBackgroundResult &&cached);
+	void rememberCachedBackground(
+		const CachedBackground &cached,
+		const QImage &gradient);
+	bool restoreCachedBackground(QSize area);
 	[[nodiscard]] bool readyForBackgroundRotation() const;
 	void generateNextBackgroundRotation();
 
-	void cacheBubbles();
-	void cacheBubblesNow();
-	void cacheBubblesAsync(
-		const CacheBackgroundRequest &request);
-	[[nodiscard]] CacheBackgroundRequest cacheBubblesRequest(
-		QSize area) const;
-
 	[[nodiscard]] style::colorizer bubblesAccentColorizer(
 		const QColor &accent) const;
 	void adjustPalette(const ChatThemeDescriptor &descriptor);
@@ -217,12 +214,14 @@ private:
 	crl::time _lastBackgroundAreaChangeTime = 0;
 	std::optional<base::Timer> _cacheBackgroundTimer;
 
-	CachedBackground _bubblesBackground;
+	// Recently generated backgrounds by area, to restore them on resize.
+	struct RecentBackground {
+		CachedBackground cached;
+		qint64 gradientKey = 0;
+	};
+	std::vector<RecentBackground> _recentBackgrounds;
+
 	QImage _bubblesBackgroundPrepared;
-	CacheBackgroundRequest _bubblesCachingRequest;
-	QSize _cacheBubblesArea;
-	crl::time _lastBubblesAreaChangeTime = 0;
-	std::optional<base::Timer> _cacheBubblesTimer;
 	std::unique_ptr<BubblePattern> _bubblesBackgroundPattern;
 
 	rpl::event_stream<> _repaintBackgroundRequests;
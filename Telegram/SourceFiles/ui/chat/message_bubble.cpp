@@ -357,18 +357,26 @@ void PaintPatternBubblePart(
 			(fill.topLeft() - viewport.topLeft()) * factor,
 			fill.size() * factor));
 	} else {
-		const auto to = viewport;
-		const auto from = QRect(QPoint(), pixmap.size());
-		const auto deviceRect = QRect(
-			QPoint(),
-			QSize(p.device()->width(), p.device()->height()));
-		const auto clip = (target != deviceRect);
-		if (clip) {
-			p.setClipRect(target);
+		// Sample only the part of the pattern that falls into the target.
+		const auto fill = target.intersected(viewport);
+		if (fill.isEmpty() || viewport.isEmpty()) {
+			return;
+		}
+		const auto scaleX = pixmap.width() / float64(viewport.width());
+		const auto scaleY = pixmap.height() / float64(viewport.height());
+		const auto from = QRectF(
+			(fill.x() - viewport.x()) * scaleX,
+			(fill.y() - viewport.y()) * scaleY,
+			fill.width() * scaleX,
+			fill.height() * scaleY);
+		const auto smooth = p.testRenderHint(
+			QPainter::SmoothPixmapTransform);
+		if (!smooth) {
+			p.setRenderHint(QPainter::SmoothPixmapTransform);
 		}
-		p.drawPixmap(to, pixmap, from);
-		if (clip) {
-			p.setClipping(false);
+		p.drawPixmap(QRectF(fill), pixmap, from);
+		if (!smooth) {
+			p.setRenderHint(QPainter::SmoothPixmapTransform, false);
 		}
 	}
 }
@@ -17,6 +17,114 @@ using namespace Images;
 namespace Images {
 namespace {
 
+constexpr auto kCachedPixmapsLimit = int64(192 * 1024 * 1024);
+constexpr auto kLogStatsInterval = 10 * 60 * crl::time(1000);
+
+crl::time StatsLoggedAt = 0;
+
+class CachedPixmaps final {
+public:
+	using Key = std::pair<const Image*, uint64>;
+
+	void hit(Key key);
+
+	// Returns true if a trim should be scheduled.
+	[[nodiscard]] bool store(Key key, const QPixmap &pixmap);
+	void forget(const Image *image, const std::vector<uint64> &keys);
+
+	[[nodiscard]] std::vector<Key> takeOverflow();
+	[[nodiscard]] CachedPixmapsStats stats() const;
+
+private:
+	struct Entry {
+		Key key;
+		int64 bytes = 0;
+	};
+
+	void remove(std::map<Key, std::list<Entry>::iterator>::iterator i);
+
+	std::list<Entry> _entries; // Least recently used first.
+	std::map<Key, std::list<Entry>::iterator> _index;
+	CachedPixmapsStats _stats = { .limit = kCachedPixmapsLimit };
+	bool _trimScheduled = false;
+
+};
+
+NeverFreedPointer<CachedPixmaps> GlobalCachedPixmaps;
+
+[[nodiscard]] not_null<CachedPixmaps*> Cache() {
+	GlobalCachedPixmaps.createIfNull();
+	return GlobalCachedPixmaps.data();
+}
+
+[[nodiscard]] int64 PixmapBytes(const QPixmap &pixmap) {
+	return int64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+}
+
+void CachedPixmaps::hit(Key key) {
+	++_stats.hits;
+	const auto i = _index.find(key);
+	if (i != end(_index)) {
+		_entries.splice(end(_entries), _entries, i->second);
+	}
+}
+
+bool CachedPixmaps::store(Key key, const QPixmap &pixmap) {
+	++_stats.misses;
+	const auto bytes = PixmapBytes(pixmap);
+	const auto i = _index.find(key);
+	if (i != end(_index)) {
+		_stats.memory += bytes - i->second->bytes;
+		i->second->bytes = bytes;
+		_entries.splice(end(_entries), _entries, i->second);
+	} else {
+		_entries.push_back({ key, bytes });
+		_index.emplace(key, std::prev(end(_entries)));
+		_stats.memory += bytes;
+		++_stats.count;
+	}
+	if (_trimScheduled || _stats.memory <= _stats.limit) {
+		return false;
+	}
+	_trimScheduled = true;
+	return true;
+}
+
+void CachedPixmaps::forget(
+		const Image *image,
+		const std::vector<uint64> &keys) {
+	for (const auto key : keys) {
+		const auto i = _index.find(Key{ image, key });
+		if (i != end(_index)) {
+			remove(i);
+		}
+	}
+}
+
+void CachedPixmaps::remove(
+		std::map<Key, std::list<Entry>::iterator>::iterator i) {
+	_stats.memory -= i->second->bytes;
+	--_stats.count;
+	_entries.erase(i->second);
+	_index.erase(i);
+}
+
+std::vector<CachedPixmaps::Key> CachedPixmaps::takeOverflow() {
+	_trimScheduled = false;
+
+	auto result = std::vector<Key>();
+	while (_stats.memory > _stats.limit && !_entries.empty()) {
+		const auto key = _entries.front().key;
+		result.push_back(key);
+		remove(_index.find(key));
+	}
+	return result;
+}
+
+CachedPixmapsStats CachedPixmaps::stats() const {
+	return _stats;
+}
+
 [[nodiscard]] uint64 PixKey(int width, int height, Options options) {
 	return static_cast<uint64>(width)
 		| (static_cast<uint64>(height) << 24)
@@ -41,6 +149,33 @@ namespace {
 
 } // namespace
 
+CachedPixmapsStats GetCachedPixmapsStats() {
+	return Cache()->stats();
+}
+
+struct PreparingPixmap {
+	const Image *image = nullptr;
+	std::vector<not_null<PrepareRequest*>> requests;
+	std::atomic<bool> cancelled = false;
+};
+
+PrepareRequest::~PrepareRequest() {
+	cancel();
+}
+
+void PrepareRequest::cancel() {
+	if (const auto preparing = base::take(_preparing)) {
+		auto &list = preparing->requests;
+		list.erase(
+			ranges::remove(list, not_null<PrepareRequest*>(this)),
+			end(list));
+		if (list.empty()) {
+			preparing->cancelled = true;
+		}
+	}
+	_ready = nullptr;
+}
+
 QByteArray ExpandInlineBytes(const QByteArray &bytes) {
 	if (bytes.size() < 3 || bytes[0] != '\x01') {
 		return QByteArray();
@@ -310,6 +445,25 @@ Image::Image(QImage &&data)
 	Expects(!_data.isNull());
 }
 
+Image::~Image() {
+	for (const auto &[key, preparing] : _preparing) {
+		preparing->image = nullptr;
+		preparing->cancelled = true;
+		for (const auto request : base::take(preparing->requests)) {
+			request->_preparing = nullptr;
+		}
+	}
+	if (_cache.empty()) {
+		return;
+	}
+	auto keys = std::vector<uint64>();
+	keys.reserve(_cache.size());
+	for (const auto &[key, pixmap] : _cache) {
+		keys.push_back(key);
+	}
+	Cache()->forget(this, keys);
+}
+
 not_null<Image*> Image::Empty() {
 	static auto result = Image([] {
 		const auto factor = cIntRetinaFactor();
@@ -342,7 +496,7 @@ QImage Image::original() const {
 	return _data;
 }
 
-const QPixmap &Image::cached(
+Image::CacheKey Image::cacheKey(
 		int w,
 		int h,
 		const Images::PrepareArgs &args,
@@ -358,12 +512,147 @@ const QPixmap &Image::cached(
 		h *= ratio;
 	}
 	const auto outer = args.outer;
-	const auto size = outer.isEmpty() ? QSize(w, h) : outer * ratio;
-	const auto k = single ? SinglePixKey(args) : PixKey(w, h, args);
-	const auto i = _cache.find(k);
-	return (i != _cache.cend() && i->second.size() == size)
-		? i->second
-		: _cache.emplace_or_assign(k, prepare(w, h, args)).first->second;
+	return {
+		.width = w,
+		.height = h,
+		.size = outer.isEmpty() ? QSize(w, h) : outer * ratio,
+		.key = single ? SinglePixKey(args) : PixKey(w, h, args),
+	};
+}
+
+const QPixmap &Image::cached(
+		int w,
+		int h,
+		const Images::PrepareArgs &args,
+		bool single) const {
+	const auto key = cacheKey(w, h, args, single);
+	const auto i = _cache.find(key.key);
+	if (i != _cache.cend() && i->second.size() == key.size) {
+		Cache()->hit({ this, key.key });
+		return i->second;
+	}
+	return store(key.key, prepare(key.width, key.height, args));
+}
+
+const QPixmap &Image::store(uint64 key, QPixmap &&pixmap) const {
+	const auto &result = _cache.emplace_or_assign(
+		key,
+		std::move(pixmap)).first->second;
+	if (Cache()->store({ this, key }, result)) {
+		// References returned from pix() must stay valid while the
+		// current paint event uses them, so evict on the next iteration.
+		crl::on_main([] { TrimCached(); });
+	}
+	return result;
+}
+
+const QPixmap &Image::cachedAsync(
+		QSize size,
+		const Images::PrepareArgs &args,
+		Images::PrepareRequest &request,
+		Fn<void()> ready) const {
+	const auto key = cacheKey(size.width(), size.height(), args, true);
+	const auto i = _cache.find(key.key);
+	if (i != _cache.cend() && i->second.size() == key.size) {
+		request.cancel();
+		request._lastImage = this;
+		request._lastKey = key.key;
+		Cache()->hit({ this, key.key });
+		return i->second;
+	} else if (isNull() || args.colored) {
+		// Empty image framing and palette colors are main thread only.
+		request.cancel();
+		return cached(size.width(), size.height(), args, true);
+	}
+	auto &preparing = _preparing[key.key];
+	if (!preparing || preparing->cancelled) {
+		if (preparing) {
+			preparing->image = nullptr;
+		}
+		preparing = std::make_shared<Images::PreparingPixmap>();
+		preparing->image = this;
+		crl::async([
+			=,
+			data = _data,
+			preparing = preparing,
+			width = key.width,
+			height = key.height,
+			key = key.key
+		]() mutable {
+			auto result = preparing->cancelled
+				? QImage()
+				: Images::Prepare(std::move(data), width, height, args);
+			crl::on_main([=, result = std::move(result)]() mutable {
+				if (const auto image = preparing->image) {
+					image->finishPreparing(
+						key,
+						preparing,
+						std::move(result));
+				}
+			});
+		});
+	}
+	if (request._preparing != preparing) {
+		request.cancel();
+		request._preparing = preparing;
+		preparing->requests.push_back(&request);
+	}
+	request._ready = std::move(ready);
+
+	if (request._lastImage == this) {
+		const auto j = _cache.find(request._lastKey);
+		if (j != _cache.cend()) {
+			return j->second;
+		}
+	}
+	static const auto kPlaceholder = QPixmap();
+	return kPlaceholder;
+}
+
+void Image::finishPreparing(
+		uint64 key,
+		std::shared_ptr<Images::PreparingPixmap> preparing,
+		QImage &&result) const {
+	const auto i = _preparing.find(key);
+	if (i != _preparing.end() && i->second == preparing) {
+		_preparing.erase(i);
+	}
+	preparing->image = nullptr;
+	if (preparing->cancelled || result.isNull()) {
+		return;
+	}
+	store(key, Ui::PixmapFromImage(std::move(result)));
+	for (const auto request : base::take(preparing->requests)) {
+		request->_preparing = nullptr;
+		request->_lastImage = this;
+		request->_lastKey = key;
+		if (const auto ready = base::take(request->_ready)) {
+			ready();
+		}
+	}
+}
+
+void Image::TrimCached() {
+	const auto cache = Cache();
+	const auto overflow = cache->takeOverflow();
+	for (const auto &[image, key] : overflow) {
+		image->_cache.remove(key);
+	}
+
+	// Write a summary from time to time, not after every eviction.
+	const auto now = crl::now();
+	if (StatsLoggedAt && now - StatsLoggedAt < kLogStatsInterval) {
+		return;
+	}
+	StatsLoggedAt = now;
+	const auto stats = GetCachedPixmapsStats();
+	DEBUG_LOG(("Images: %1 pixmaps using %2 of %3 bytes, "
+		"%4 hits, %5 misses."
+		).arg(stats.count
+		).arg(stats.memory
+		).arg(stats.limit
+		).arg(stats.hits
+		).arg(stats.misses));
 }
 
 QPixmap Image::prepare(int w, int h, const Images::PrepareArgs &args) const {
@@ -10,6 +10,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/image/image_prepare.h"
 
 class QPainterPath;
+class Image;
 
 namespace Images {
 
@@ -17,6 +18,40 @@ namespace Images {
 [[nodiscard]] QImage FromInlineBytes(const QByteArray &bytes);
 [[nodiscard]] QPainterPath PathFromInlineBytes(const QByteArray &bytes);
 
+struct CachedPixmapsStats {
+	uint64 hits = 0;
+	uint64 misses = 0;
+	int64 memory = 0;
+	int64 limit = 0;
+	int count = 0;
+};
+
+// Prepared pixmaps of all Image instances share one LRU byte budget.
+[[nodiscard]] CachedPixmapsStats GetCachedPixmapsStats();
+
+struct PreparingPixmap;
+
+// Tracks one view's background preparation through Image::pixSingleAsync().
+// Destroying or cancelling it drops the work if nobody else waits for it.
+class PrepareRequest final {
+public:
+	PrepareRequest() = default;
+	PrepareRequest(const PrepareRequest &other) = delete;
+	PrepareRequest &operator=(const PrepareRequest &other) = delete;
+	~PrepareRequest();
+
+	void cancel();
+
+private:
+	friend class ::Image;
+
+	std::shared_ptr<PreparingPixmap> _preparing;
+	Fn<void()> _ready;
+	const Image *_lastImage = nullptr;
+	uint64 _lastKey = 0;
+
+};
+
 } // namespace Images
 
 class Image final {
@@ -24,6 +59,7 @@ public:
 	explicit Image(const QString &path);
 	explicit Image(const QByteArray &content);
 	explicit Image(QImage &&data);
+	~Image();
 
 	[[nodiscard]] static not_null<Image*> Empty(); // 1x1 transparent
 	[[nodiscard]] static not_null<Image*> BlankMedia(); // 1x1 black
@@ -78,6 +114,17 @@ public:
 		return cached(w, 0, args, true);
 	}
 
+	// Returns the cached pixmap or the last one this request received,
+	// prepares the requested one on a background thread, then ready().
+	// A null pixmap is returned while nothing is ready yet.
+	[[nodiscard]] const QPixmap &pixSingleAsync(
+			QSize size,
+			const Images::PrepareArgs &args,
+			Images::PrepareRequest &request,
+			Fn<void()> ready) const {
+		return cachedAsync(size, args, request, std::move(ready));
+	}
+
 	[[nodiscard]] QPixmap pixNoCache(
 			QSize size,
 			const Images::PrepareArgs &args = {}) const {
@@ -96,6 +143,18 @@ public:
 	}
 
 private:
+	struct CacheKey {
+		int width = 0;
+		int height = 0;
+		QSize size;
+		uint64 key = 0;
+	};
+
+	[[nodiscard]] CacheKey cacheKey(
+		int w,
+		int h,
+		const Images::PrepareArgs &args,
+		bool single) const;
 	[[nodiscard]] QPixmap prepare(
 		int w,
 		int h,
@@ -105,8 +164,23 @@ private:
 		int h,
 		const Images::PrepareArgs &args,
 		bool single) const;
+	[[nodiscard]] const QPixmap &cachedAsync(
+		QSize size,
+		const Images::PrepareArgs &args,
+		Images::PrepareRequest &request,
+		Fn<void()> ready) const;
+	const QPixmap &store(uint64 key, QPixmap &&pixmap) const;
+	void finishPreparing(
+		uint64 key,
+		std::shared_ptr<Images::PreparingPixmap> preparing,
+		QImage &&result) const;
+
+	static void TrimCached();
 
 	const QImage _data;
 	mutable base::flat_map<uint64, QPixmap> _cache;
+	mutable base::flat_map<
+		uint64,
+		std::shared_ptr<Images::PreparingPixmap>> _preparing;
 
 };